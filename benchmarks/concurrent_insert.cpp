@@ -0,0 +1,93 @@
+// Insert throughput as the writer count grows: ConcurrentBucketStorage against a BucketStorage behind one mutex.
+// Every thread inserts the same number of elements, so with perfect scaling the total throughput grows with the
+// thread count.
+//   g++ -std=c++20 -O2 -pthread -I.. concurrent_insert.cpp -o concurrent_insert
+//   ./concurrent_insert [max_threads] [inserts_per_thread]
+
+#include "bucket_storage.hpp"
+#include "concurrent_bucket_storage.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr std::size_t block_capacity = 256;
+	constexpr int repetitions = 5;
+
+	// Best of several runs, each on a fresh storage, of `threads` writers released together; in seconds.
+	template< typename Storage, typename Insert >
+	double best_run(const std::size_t threads, const std::size_t per_thread, Insert insert)
+	{
+		double best = -1;
+		for (int r = 0; r < repetitions; ++r)
+		{
+			Storage storage(block_capacity);
+			std::atomic< bool > go{ false };
+			std::vector< std::thread > pool;
+			pool.reserve(threads);
+			for (std::size_t t = 0; t < threads; ++t)
+			{
+				pool.emplace_back(
+					[&, t]
+					{
+						while (!go.load(std::memory_order_acquire))
+						{
+							std::this_thread::yield();
+						}
+						for (std::size_t i = 0; i < per_thread; ++i)
+						{
+							insert(storage, static_cast< long >(t * per_thread + i));
+						}
+					});
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			go.store(true, std::memory_order_release);
+			for (std::thread& thread : pool)
+			{
+				thread.join();
+			}
+			const double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+			best = best < 0 || seconds < best ? seconds : best;
+		}
+		return best;
+	}
+}	 // namespace
+
+int main(int argc, char** argv)
+{
+	const std::size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+	const std::size_t per_thread = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+
+	std::printf("hardware threads: %u, inserts per thread: %zu\n", std::thread::hardware_concurrency(), per_thread);
+	std::printf("%8s %18s %18s %10s\n", "threads", "concurrent Mop/s", "mutex Mop/s", "scaling");
+
+	double single = 0;
+	std::mutex mutex;
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+	{
+		const double inserts = static_cast< double >(threads * per_thread);
+		const double concurrent = best_run< ConcurrentBucketStorage< long > >(
+			threads, per_thread, [](ConcurrentBucketStorage< long >& storage, long value) { storage.insert(value); });
+		const double locked = best_run< BucketStorage< long > >(
+			threads,
+			per_thread,
+			[&mutex](BucketStorage< long >& storage, long value)
+			{
+				std::lock_guard< std::mutex > lock(mutex);
+				storage.insert(value);
+			});
+
+		// Scaling is the concurrent throughput over the single-thread throughput; linear scaling equals the thread count.
+		const double throughput = inserts / concurrent;
+		single = threads == 1 ? throughput : single;
+		std::printf("%8zu %18.1f %18.1f %10.2f\n", threads, throughput / 1e6, inserts / locked / 1e6, throughput / single);
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+// Iterator traversal with and without checks. Build it once per mode and compare:
+//   g++ -std=c++20 -O2 -I.. -DBUCKET_STORAGE_CHECKED_ITERATORS=1 iteration.cpp -o iteration_checked
+//   g++ -std=c++20 -O2 -I.. -DBUCKET_STORAGE_CHECKED_ITERATORS=0 iteration.cpp -o iteration_unchecked
+
+#include "bucket_storage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr std::size_t element_count = 1000000;
+	constexpr std::size_t block_capacity = 64;
+	constexpr int repetitions = 15;
+
+	// Best of several full traversals, so one noisy run does not decide the result.
+	long long best_traversal_us(const BucketStorage< long >& storage, long& sum)
+	{
+		long long best = -1;
+		for (int r = 0; r < repetitions; ++r)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (auto it = storage.begin(); it != storage.end(); ++it)
+			{
+				sum += *it;
+			}
+			const auto stop = std::chrono::steady_clock::now();
+			const long long us = std::chrono::duration_cast< std::chrono::microseconds >(stop - start).count();
+			best = best < 0 || us < best ? us : best;
+		}
+		return best;
+	}
+}	 // namespace
+
+int main()
+{
+	std::printf("checked iterators: %d\n", BUCKET_STORAGE_CHECKED_ITERATORS);
+	for (const bool churn : { false, true })
+	{
+		BucketStorage< long > storage(block_capacity);
+		std::vector< BucketStorage< long >::iterator > its;
+		its.reserve(element_count);
+		for (std::size_t i = 0; i < element_count; ++i)
+		{
+			its.push_back(storage.insert(static_cast< long >(i)));
+		}
+
+		// Erase half the elements at random and refill, so traversal order no longer follows the slots.
+		if (churn)
+		{
+			std::mt19937 gen(1);
+			std::shuffle(its.begin(), its.end(), gen);
+			for (std::size_t i = 0; i < element_count / 2; ++i)
+			{
+				storage.erase(its[i]);
+			}
+			for (std::size_t i = 0; i < element_count / 2; ++i)
+			{
+				storage.insert(static_cast< long >(i));
+			}
+		}
+
+		long sum = 0;
+		const long long us = best_traversal_us(storage, sum);
+		std::printf("%s: %lld us (checksum %ld)\n", churn ? "churned" : "dense", us, sum);
+	}
+	return 0;
+}
@@ -1,7 +1,32 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// BUCKET_STORAGE_CHECKED_ITERATORS selects the iterator checking mode: 1 validates every iterator
+// operation and throws std::runtime_error, 0 performs no checks and makes traversal noexcept.
+#ifndef BUCKET_STORAGE_CHECKED_ITERATORS
+	#ifdef NDEBUG
+		#define BUCKET_STORAGE_CHECKED_ITERATORS 0
+	#else
+		#define BUCKET_STORAGE_CHECKED_ITERATORS 1
+	#endif
+#endif
 
 // INTERFACE
 
@@ -9,6 +34,40 @@ namespace detail
 {
 	using size_type = std::size_t;
 
+	inline constexpr bool checked_iterators = BUCKET_STORAGE_CHECKED_ITERATORS != 0;
+	inline constexpr size_type cache_line_size = 64;
+	inline constexpr size_type prefetch_lines = 4;
+	inline constexpr size_type page_size = 4096;
+	inline constexpr size_type destroy_batch = 64;
+
+	void prefetch(const void* address, size_type bytes = 1) noexcept;
+	void prefault(void* address, size_type bytes) noexcept;
+	size_type worker_count(size_type requested, size_type tasks) noexcept;
+	size_type next_mark_id() noexcept;
+	template< typename F >
+	void run_parallel(size_type workers, F task);
+
+	// Per-worker accounting of a parallel traversal; imbalance() is the busiest worker's share over the mean.
+	struct ParallelStats
+	{
+		std::vector< size_type > m_elements;
+		std::vector< size_type > m_blocks;
+		std::vector< size_type > m_steals;
+
+		[[nodiscard]] double imbalance() const noexcept;
+	};
+
+	// A contiguous range of task indices owned by one worker; the owner pops from the front, thieves split off the back half of its weight.
+	struct WorkRange
+	{
+		std::mutex m_mutex;
+		size_type m_begin{};
+		size_type m_end{};
+	};
+
+	template< typename F >
+	void run_stealing(const std::vector< size_type >& weights, size_type workers, F task, ParallelStats* stats);
+
 	template< typename U >
 	struct Node
 	{
@@ -34,6 +93,8 @@ namespace detail
 		void push_back(const U& value);
 		void erase(NodeType* target);
 		void pop_back();
+		void splice_back(List& other, NodeType* first) noexcept;
+		void transfer_back(List& other, NodeType* node) noexcept;
 		[[nodiscard]] NodeType* front() const noexcept;
 		[[nodiscard]] NodeType* back() const noexcept;
 		[[nodiscard]] bool empty() const noexcept;
@@ -46,6 +107,49 @@ namespace detail
 		NodeType* m_head{};
 		NodeType* m_tail{};
 	};
+
+	// Where an insert takes its slot from: the most recently freed block, the block with the most live elements, or the
+	// block earliest in traversal order.
+	enum class SlotPolicy
+	{
+		lifo,
+		fullest_first,
+		lowest_address_first
+	};
+
+	// Hierarchical bitmap; each level flags the non-zero words of the one below, so every operation is O(log64 n).
+	struct BitTree
+	{
+		static constexpr size_type npos = static_cast< size_type >(-1);
+
+		void resize(size_type count);
+		void set(size_type index) noexcept;
+		void reset(size_type index) noexcept;
+		[[nodiscard]] size_type first() const noexcept;
+		[[nodiscard]] size_type last() const noexcept;
+		void clear() noexcept;
+		void swap(BitTree& other) noexcept;
+
+	  private:
+		std::vector< std::vector< std::uint64_t > > m_levels;
+	};
+
+	// Fenwick tree over block occupancy: prefix sums and rank lookup in O(log n).
+	struct Fenwick
+	{
+		void push_back(size_type value);
+		void reserve(size_type count);
+		void add(size_type index, std::ptrdiff_t delta) noexcept;
+		void assign(const std::vector< size_type >& values);
+		[[nodiscard]] size_type prefix(size_type count) const noexcept;
+		[[nodiscard]] size_type lower_bound(size_type& rank) const noexcept;
+		[[nodiscard]] size_type size() const noexcept;
+		void clear() noexcept;
+		void swap(Fenwick& other) noexcept;
+
+	  private:
+		std::vector< size_type > m_tree{ 0 };
+	};
 }	 // namespace detail
 
 template< typename T >
@@ -54,6 +158,8 @@ class BucketStorage
 	template< typename U >
 	struct BSIterator;
 
+	struct BSSentinel;
+
 	struct Block;
 
   public:
@@ -64,6 +170,20 @@ class BucketStorage
 	using size_type = std::size_t;
 	using iterator = BSIterator< T >;
 	using const_iterator = BSIterator< const T >;
+	using sentinel = BSSentinel;
+	using ParallelStats = detail::ParallelStats;
+	using SlotPolicy = detail::SlotPolicy;
+
+	// A checkpoint from mark(): the back block then, its used slot count, and the serial the next new block receives.
+	// m_id is unique per process, so a mark is accepted only by the storage whose active stack still holds it.
+	struct Mark
+	{
+		size_type m_serial{};
+		size_type m_next_serial{};
+		size_type m_used{};
+		size_type m_depth{};
+		size_type m_id{};
+	};
 
   private:
 	using Node = detail::Node< value_type* >;
@@ -72,43 +192,63 @@ class BucketStorage
 	struct BSIterator
 	{
 		using iterator_category = std::bidirectional_iterator_tag;
-		using value_type = Node*;
+		using iterator_concept = std::bidirectional_iterator_tag;
+		using value_type = std::remove_cv_t< U >;
 		using difference_type = std::ptrdiff_t;
 		using pointer = U*;
 		using reference = U&;
 
 	  private:
-		value_type m_node{};
+		Node* m_node{};
 		Block* m_block{};
 
+		void check_valid(const char* operation) const;
+
 	  public:
+		BSIterator() = default;
 		BSIterator(const iterator& other);
-		BSIterator(value_type node, Block* block);
+		BSIterator(Node* node, Block* block);
 		BSIterator& operator=(const iterator& other);
-		BSIterator operator++(int);
-		BSIterator& operator++();
-		BSIterator operator--(int);
-		BSIterator& operator--();
-		bool operator<(const BSIterator& other) const;
-		bool operator>(const BSIterator& other) const;
-		bool operator<=(const BSIterator& other) const;
-		bool operator>=(const BSIterator& other) const;
+		BSIterator operator++(int) noexcept(!detail::checked_iterators);
+		BSIterator& operator++() noexcept(!detail::checked_iterators);
+		BSIterator operator--(int) noexcept(!detail::checked_iterators);
+		BSIterator& operator--() noexcept(!detail::checked_iterators);
+		bool operator<(const BSIterator& other) const noexcept(!detail::checked_iterators);
+		bool operator>(const BSIterator& other) const noexcept(!detail::checked_iterators);
+		bool operator<=(const BSIterator& other) const noexcept(!detail::checked_iterators);
+		bool operator>=(const BSIterator& other) const noexcept(!detail::checked_iterators);
 		bool operator==(const BSIterator& other) const noexcept;
-		pointer operator->();
-		reference operator*();
-		value_type node() const noexcept;
+		bool operator==(const BSSentinel& other) const noexcept;
+		pointer operator->() const noexcept(!detail::checked_iterators);
+		reference operator*() const noexcept(!detail::checked_iterators);
+		Node* node() const noexcept;
 		Block* block() const noexcept;
 	};
 
+	// Compares equal to any iterator positioned at the end node; a single pointer comparison.
+	struct BSSentinel
+	{
+		Node* m_end{};
+	};
+
 	struct Block
 	{
 		Node* m_values;
 		size_type m_index;
 		size_type m_size{};
+		size_type m_used{};
+		size_type m_pending{};
 		detail::List< Node* > m_stack;
 		typename detail::List< Block* >::NodeType* m_node{};
+		typename detail::List< Block* >::NodeType* m_free_node{};
+		typename detail::List< Block* >::NodeType* m_bucket_node{};
+		size_type m_bucket{};
+		size_type m_serial{};
+		Node* m_first{};
+		Node* m_last{};
 		value_type* m_data;
 		size_type m_block_capacity;
+		std::shared_ptr< void > m_owner{};
 
 		explicit Block(const size_type block_capacity, const size_type index) :
 			m_values(new Node[block_capacity]), m_index(index),
@@ -116,23 +256,117 @@ class BucketStorage
 		{
 		}
 
+		// Wraps elements living in an adopted buffer; the buffer is released once every block sharing m_owner is gone.
+		Block(const size_type block_capacity, value_type* data, std::shared_ptr< void > owner) :
+			m_values(new Node[block_capacity]), m_index(0), m_data(data), m_block_capacity(block_capacity), m_owner(std::move(owner))
+		{
+		}
+
 		~Block()
 		{
 			delete[] m_values;
-			operator delete(m_data);
+			if (!m_owner)
+			{
+				operator delete(m_data);
+			}
 		}
 	};
 
+	// Background thread keeping pre-faulted blocks in handoff slots, so push_block only pops a prepared block.
+	struct BlockPreparer
+	{
+		size_type m_block_capacity;
+		std::vector< std::atomic< Block* > > m_ready;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_pending{};
+		bool m_stop{};
+		std::thread m_thread;
+
+		BlockPreparer(size_type block_capacity, size_type ready);
+		~BlockPreparer();
+		Block* take();
+		void run();
+	};
+
+	// An erased element whose destructor has not run yet; its slot stays out of the free list until it has.
+	struct Dead
+	{
+		Block* m_block;
+		Node* m_node;
+
+		value_type* element() const noexcept;
+	};
+
+	// Background thread running deferred destructors; destroyed entries come back through m_done.
+	struct Reaper
+	{
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		std::vector< Dead > m_queue;
+		std::vector< Dead > m_done;
+		bool m_busy{};
+		bool m_stop{};
+		std::thread m_thread;
+
+		Reaper();
+		~Reaper();
+		void submit(std::vector< Dead >& batch);
+		std::vector< Dead > take_done();
+		std::vector< Dead > finish();
+		void run();
+	};
+
 	size_type m_block_capacity;
 	size_type m_size{};
-	size_type m_blocks_count{};
+	size_type m_capacity{};
 	Node* m_end;
 	Node* m_front;
 	detail::List< Block* > m_list{};
 	detail::List< Block* > m_stack{};
+	std::vector< Block* > m_blocks{};
+	detail::Fenwick m_occupancy{};
+	bool m_append_only{};
+	std::atomic< size_type > m_published{};
+	std::unique_ptr< BlockPreparer > m_preparer{};
+	bool m_deferred{};
+	std::vector< Dead > m_dead{};
+	std::unique_ptr< Reaper > m_reaper{};
+	SlotPolicy m_policy{};
+	std::vector< detail::List< Block* > > m_buckets{};
+	detail::BitTree m_bucket_index{};
+	detail::BitTree m_free_index{};
+	size_type m_next_serial{};
+	std::vector< Mark > m_marks{};
 
 	template< typename U >
 	iterator insert_impl(U&& value);
+	template< typename U >
+	iterator emplace_in(Block* block, U&& value);
+	Block* push_block();
+	void release_block(Block* block);
+	void reindex();
+	void link_node(Block* block, Node* node) noexcept;
+	void unlink_node(Block* block, Node* node) noexcept;
+	void refresh_free(Block* block);
+	void register_free(Block* block);
+	void unregister_free(Block* block) noexcept;
+	Block* pick_free() const noexcept;
+	bool appending() const noexcept;
+	static bool within(const Mark& mark, const Block* block) noexcept;
+	void adopt_blocks(BucketStorage& from, typename detail::List< Block* >::NodeType* first);
+	void recycle(std::vector< Dead >& dead, bool reuse);
+	std::vector< Block* > block_list() const;
+	static std::vector< size_type > block_weights(const std::vector< Block* >& blocks);
+	template< typename F >
+	static void visit_block(Block* block, F& f);
+	template< typename It >
+	static void fill_block(Block* block, It source, size_type count);
+	template< typename F >
+	static void visit_runs(Block* block, F f);
+	template< bool Move >
+	static void append_run(std::vector< value_type >& out, value_type* first, size_type count);
 
   public:
 	BucketStorage();
@@ -157,7 +391,52 @@ class BucketStorage
 	[[nodiscard]] iterator end() noexcept;
 	[[nodiscard]] const_iterator end() const noexcept;
 	[[nodiscard]] const_iterator cend() noexcept;
+	[[nodiscard]] auto view() noexcept;
+	[[nodiscard]] auto view() const noexcept;
 	[[nodiscard]] iterator get_to_distance(iterator it, difference_type distance);
+	[[nodiscard]] difference_type distance(const_iterator first, const_iterator last) const;
+	[[nodiscard]] iterator nth(size_type index);
+	[[nodiscard]] const_iterator nth(size_type index) const;
+	[[nodiscard]] size_type index_of(const_iterator it) const;
+	void set_append_only(bool enabled) noexcept;
+	[[nodiscard]] bool append_only() const noexcept;
+	[[nodiscard]] size_type published() const noexcept;
+	template< typename F >
+	F for_each_published(F f) const;
+	template< typename F >
+	F for_each(F f, size_type prefetch_distance = 8);
+	template< typename F >
+	F for_each(F f, size_type prefetch_distance = 8) const;
+	template< typename F >
+	void parallel_for_each(F f, size_type threads = 0, ParallelStats* stats = nullptr);
+	template< typename F >
+	void parallel_for_each(F f, size_type threads = 0, ParallelStats* stats = nullptr) const;
+	template< typename R, typename BinaryOp >
+	R parallel_reduce(R init, BinaryOp op, size_type threads = 0, bool deterministic = false, ParallelStats* stats = nullptr) const;
+	template< typename F >
+	void parallel_transform_inplace(F f, size_type threads = 0, ParallelStats* stats = nullptr);
+	template< std::random_access_iterator It >
+	void assign(It first, It last, size_type threads = 0);
+	template< typename Relocate >
+	size_type compact_step(size_type budget, Relocate relocate);
+	void relink_in_address_order() noexcept;
+	void splice(BucketStorage&& other);
+	[[nodiscard]] BucketStorage split(const_iterator pos);
+	void drain_to(std::vector< value_type >& out);
+	template< typename Deleter >
+	void adopt(value_type* buffer, size_type n, Deleter deleter);
+	[[nodiscard]] std::vector< value_type > to_vector() const;
+	template< typename KeyFn, typename Relocate >
+	void reorder_by(KeyFn key, Relocate relocate);
+	void start_block_preparer(size_type ready_blocks = 1);
+	void stop_block_preparer() noexcept;
+	void set_deferred_destruction(bool enabled, bool background = false);
+	[[nodiscard]] bool deferred_destruction() const noexcept;
+	void collect();
+	void set_slot_policy(SlotPolicy policy);
+	[[nodiscard]] SlotPolicy slot_policy() const noexcept;
+	[[nodiscard]] Mark mark();
+	void rollback(const Mark& mark);
 };
 
 // BUCKETSTORAGE IMPLEMENTATION
@@ -169,8 +448,9 @@ BucketStorage< T >::BucketStorage() : m_block_capacity(64), m_end(new Node()), m
 
 template< typename T >
 BucketStorage< T >::BucketStorage(const BucketStorage& other) :
-	m_block_capacity(other.m_block_capacity), m_end(new Node())
+	m_block_capacity(other.m_block_capacity), m_end(new Node()), m_front(m_end)
 {
+	set_slot_policy(other.m_policy);
 	for (auto it = other.begin(); it != other.end(); ++it)
 	{
 		insert(*it);
@@ -178,7 +458,7 @@ BucketStorage< T >::BucketStorage(const BucketStorage& other) :
 }
 
 template< typename T >
-BucketStorage< T >::BucketStorage(BucketStorage&& other) noexcept : m_block_capacity(64), m_end(new Node())
+BucketStorage< T >::BucketStorage(BucketStorage&& other) noexcept : m_block_capacity(64), m_end(new Node()), m_front(m_end)
 {
 	swap(other);
 }
@@ -234,108 +514,362 @@ template< typename T >
 template< typename U >
 typename BucketStorage< T >::iterator BucketStorage< T >::insert_impl(U&& value)
 {
-	if (m_size == capacity())
+	Block* block;
+	if (appending())
+	{
+		Block* back = m_list.empty() ? nullptr : m_list.back()->m_value;
+		const bool usable = back && back->m_used < back->m_block_capacity && (m_marks.empty() || within(m_marks.back(), back));
+		block = usable ? back : push_block();
+	}
+	else
+	{
+		if (m_stack.empty() && m_reaper)
+		{
+			std::vector< Dead > done = m_reaper->take_done();
+			recycle(done, true);
+		}
+		block = m_stack.empty() ? push_block() : pick_free();
+	}
+	return emplace_in(block, std::forward< U >(value));
+}
+
+template< typename T >
+template< typename U >
+typename BucketStorage< T >::iterator BucketStorage< T >::emplace_in(Block* block, U&& value)
+{
+	const bool reused = !appending() && !block->m_stack.empty();
+	Node* curr = reused ? block->m_stack.back()->m_value : block->m_values + block->m_used;
+	size_type index = curr - block->m_values;
+
+	new (block->m_data + index) value_type(std::forward< U >(value));
+	curr->m_value = block->m_data + index;
+
+	if (reused)
 	{
-		m_list.push_back(new Block(m_block_capacity, m_blocks_count));
-		m_list.back()->m_value->m_node = m_list.back();
-		++m_blocks_count;
+		block->m_stack.pop_back();
+	}
+	else
+	{
+		++block->m_used;
 	}
 
-	Node* curr;
-	Block* block = m_list.back()->m_value;
-	if (!m_stack.empty())
+	link_node(block, curr);
+	++block->m_size;
+	++m_size;
+	m_occupancy.add(block->m_index, 1);
+
+	refresh_free(block);
+
+	if (m_append_only)
+	{
+		m_published.store(m_size, std::memory_order_release);
+	}
+	return iterator(curr, block);
+}
+
+template< typename T >
+typename BucketStorage< T >::iterator BucketStorage< T >::erase(const_iterator it)
+{
+	if (!(it.node() && it.block()))
+	{
+		throw std::runtime_error("Attempt to erase by uninitialized iterator.");
+	}
+	if (!it.node()->m_value)
+	{
+		throw std::runtime_error("Attempt to erase by end or erased element iterator.");
+	}
+	if (m_append_only)
 	{
-		curr = m_stack.back()->m_value->m_stack.back()->m_value;
-		size_type index = curr - block->m_values;
+		throw std::runtime_error("Attempt to erase from append-only storage.");
+	}
+
+	Node* curr_node = it.node();
+	Block* curr_block = it.block();
+	Node* next_node = curr_node->m_next;
+	Block* next_block = curr_block;
+
+	if (curr_node == curr_block->m_last && curr_block->m_node->m_next)
+	{
+		next_block = curr_block->m_node->m_next->m_value;
+	}
+
+	if (m_deferred)
+	{
+		m_dead.push_back({ curr_block, curr_node });
+		++curr_block->m_pending;
+	}
+	else
+	{
+		curr_node->m_value->~value_type();
+	}
+	curr_node->m_value = nullptr;
 
-		curr = block->m_values + index;
-		new (block->m_data + index) value_type(std::forward< U >(value));
-		curr->m_value = block->m_data + index;
-		m_stack.back()->m_value->m_stack.pop_back();
+	unlink_node(curr_block, curr_node);
+	--curr_block->m_size;
+	--m_size;
+	m_occupancy.add(curr_block->m_index, -1);
 
-		if (m_stack.back()->m_value->m_stack.size() == 0)
+	if (curr_block->m_size == 0)
+	{
+		release_block(curr_block);
+		if (next_block == curr_block)
+		{
+			next_block = m_list.empty() ? nullptr : m_list.back()->m_value;
+		}
+	}
+	else
+	{
+		if (!m_deferred)
 		{
-			m_stack.pop_back();
+			curr_block->m_stack.push_back(curr_node);
 		}
+		refresh_free(curr_block);
+	}
+
+	if (m_reaper && m_dead.size() >= detail::destroy_batch)
+	{
+		m_reaper->submit(m_dead);
+	}
+	return iterator(next_node, next_block);
+}
+
+template< typename T >
+typename BucketStorage< T >::Block* BucketStorage< T >::push_block()
+{
+	Block* block = m_preparer ? m_preparer->take() : nullptr;
+	if (block)
+	{
+		block->m_index = m_blocks.size();
 	}
 	else
 	{
-		size_type index = m_size % m_block_capacity;
+		block = new Block(m_block_capacity, m_blocks.size());
+	}
+	block->m_serial = m_next_serial++;
+	m_list.push_back(block);
+	block->m_node = m_list.back();
+	m_blocks.push_back(block);
+	m_occupancy.push_back(0);
+	m_capacity += block->m_block_capacity;
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.resize(m_blocks.size());
+	}
+	register_free(block);
+	return block;
+}
+
+template< typename T >
+void BucketStorage< T >::release_block(Block* block)
+{
+	if (block->m_free_node)
+	{
+		unregister_free(block);
+	}
+	m_list.erase(block->m_node);
+	block->m_node = nullptr;
+	m_blocks[block->m_index] = nullptr;
+	m_capacity -= block->m_block_capacity;
+
+	// A detached block with destructors still pending is deleted by recycle once the last one has run.
+	if (block->m_pending == 0)
+	{
+		delete block;
+	}
+
+	if (m_blocks.size() > 2 * m_list.size())
+	{
+		reindex();
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::reindex()
+{
+	std::vector< size_type > sizes;
+	sizes.reserve(m_list.size());
+	m_blocks.clear();
+
+	for (auto node = m_list.front(); node; node = node->m_next)
+	{
+		node->m_value->m_index = m_blocks.size();
+		m_blocks.push_back(node->m_value);
+		sizes.push_back(node->m_value->m_size);
+	}
 
-		curr = block->m_values + index;
-		new (block->m_data + index) value_type(std::forward< U >(value));
-		curr->m_value = block->m_data + index;
+	m_occupancy.assign(sizes);
 
-		if (m_size != 0)
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.clear();
+		for (auto node = m_stack.front(); node; node = node->m_next)
 		{
-			m_end->m_prev->m_next = curr;
-			curr->m_prev = m_end->m_prev;
+			m_free_index.set(node->m_value->m_index);
 		}
-		else
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::link_node(Block* block, Node* node) noexcept
+{
+	Node* next = m_end;
+	if (block->m_last)
+	{
+		next = block->m_last->m_next;
+	}
+	else
+	{
+		for (auto it = block->m_node->m_next; it; it = it->m_next)
 		{
-			m_front = curr;
+			if (it->m_value->m_first)
+			{
+				next = it->m_value->m_first;
+				break;
+			}
 		}
+	}
 
-		curr->m_next = m_end;
-		m_end->m_prev = curr;
-		++m_list.back()->m_value->m_size;
+	node->m_next = next;
+	node->m_prev = next->m_prev;
+	if (node->m_prev)
+	{
+		node->m_prev->m_next = node;
+	}
+	else
+	{
+		m_front = node;
 	}
+	next->m_prev = node;
 
-	++m_size;
-	return iterator(curr, m_list.back()->m_value);
+	if (!block->m_first)
+	{
+		block->m_first = node;
+	}
+	block->m_last = node;
 }
 
 template< typename T >
-typename BucketStorage< T >::iterator BucketStorage< T >::erase(const_iterator it)
+void BucketStorage< T >::unlink_node(Block* block, Node* node) noexcept
 {
-	if (!(it.node() && it.block()))
+	if (node->m_prev)
 	{
-		throw std::runtime_error("Attempt to erase by uninitialized iterator.");
+		node->m_prev->m_next = node->m_next;
 	}
+	else
+	{
+		m_front = node->m_next;
+	}
+	node->m_next->m_prev = node->m_prev;
 
-	Node* curr_node = it.node();
-	Block* curr_block = it.block();
+	if (block->m_first == block->m_last)
+	{
+		block->m_first = nullptr;
+		block->m_last = nullptr;
+	}
+	else if (node == block->m_first)
+	{
+		block->m_first = node->m_next;
+	}
+	else if (node == block->m_last)
+	{
+		block->m_last = node->m_prev;
+	}
+}
 
-	curr_block->m_stack.push_back(curr_node);
-	if (curr_block->m_stack.size() == 1)
+template< typename T >
+typename BucketStorage< T >::size_type BucketStorage< T >::index_of(const_iterator it) const
+{
+	if (it.node() == m_end)
 	{
-		m_stack.push_back(curr_block);
+		return m_size;
 	}
 
-	curr_node->m_value->~value_type();
-	curr_node->m_value = nullptr;
+	Block* block = it.block();
+	size_type result = m_occupancy.prefix(block->m_index);
+	for (Node* curr = block->m_first; curr != it.node(); curr = curr->m_next)
+	{
+		++result;
+	}
+	return result;
+}
 
-	if (curr_node->m_prev && curr_node->m_next)
+template< typename T >
+typename BucketStorage< T >::iterator BucketStorage< T >::nth(size_type index)
+{
+	if (index >= m_size)
 	{
-		curr_node->m_next->m_prev = curr_node->m_prev;
-		curr_node->m_prev->m_next = curr_node->m_next;
+		if (index > m_size)
+		{
+			throw std::out_of_range("Attempt to access element past the end of the container.");
+		}
+		return end();
 	}
-	else if (!curr_node->m_prev && curr_node->m_next)
+
+	Block* block = m_blocks[m_occupancy.lower_bound(index)];
+	Node* curr;
+	if (index <= block->m_size / 2)
 	{
-		curr_node->m_next->m_prev = nullptr;
-		m_front = curr_node->m_next;
+		curr = block->m_first;
+		for (; index > 0; --index)
+		{
+			curr = curr->m_next;
+		}
 	}
 	else
 	{
-		curr_node->m_prev->m_next = nullptr;
+		curr = block->m_last;
+		for (size_type i = block->m_size - 1; i > index; --i)
+		{
+			curr = curr->m_prev;
+		}
 	}
+	return iterator(curr, block);
+}
 
-	--curr_block->m_size;
-	--m_size;
+template< typename T >
+typename BucketStorage< T >::const_iterator BucketStorage< T >::nth(size_type index) const
+{
+	return const_cast< BucketStorage* >(this)->nth(index);
+}
+
+template< typename T >
+void BucketStorage< T >::set_append_only(const bool enabled) noexcept
+{
+	m_append_only = enabled;
+	m_published.store(m_size, std::memory_order_release);
+}
+
+template< typename T >
+bool BucketStorage< T >::append_only() const noexcept
+{
+	return m_append_only;
+}
+
+template< typename T >
+typename BucketStorage< T >::size_type BucketStorage< T >::published() const noexcept
+{
+	return m_published.load(std::memory_order_acquire);
+}
 
-	if (curr_node->m_next && !(curr_block->m_values <= curr_node && curr_node <= curr_block->m_values + curr_block->m_block_capacity))
+template< typename T >
+template< typename F >
+F BucketStorage< T >::for_each_published(F f) const
+{
+	// Stops at the last published node without reading its links, which the writer may be updating.
+	size_type count = m_published.load(std::memory_order_acquire);
+	if (count == 0)
 	{
-		curr_block = curr_block->m_node->m_next->m_value;
+		return f;
 	}
 
-	if (curr_block->m_size == 0)
+	Node* curr = m_front;
+	f(static_cast< const_reference >(*curr->m_value));
+	while (--count > 0)
 	{
-		auto tmp = it.block()->m_node;
-		delete it.block();
-		m_list.erase(tmp);
+		curr = curr->m_next;
+		f(static_cast< const_reference >(*curr->m_value));
 	}
-
-	return iterator(curr_node, curr_block);
+	return f;
 }
 
 template< typename T >
@@ -353,36 +887,70 @@ typename BucketStorage< T >::size_type BucketStorage< T >::size() const noexcept
 template< typename T >
 typename BucketStorage< T >::size_type BucketStorage< T >::capacity() const noexcept
 {
-	return m_list.size() * m_block_capacity;
+	return m_capacity;
 }
 
 template< typename T >
 void BucketStorage< T >::shrink_to_fit()
 {
 	BucketStorage temp = BucketStorage(m_block_capacity);
+	temp.set_slot_policy(m_policy);
 	for (iterator it = begin(); it != end(); ++it)
 	{
 		temp.insert(std::move(*it));
 	}
+
+	collect();
+	temp.m_append_only = m_append_only;
+	temp.m_deferred = m_deferred;
+	temp.m_preparer.swap(m_preparer);
+	temp.m_reaper.swap(m_reaper);
 	swap(temp);
+	m_published.store(m_size, std::memory_order_release);
 }
 
 template< typename T >
 void BucketStorage< T >::clear() noexcept
 {
-	while (!empty())
+	std::vector< Dead > dead;
+	dead.swap(m_dead);
+	for (const Dead& entry : dead)
+	{
+		entry.element()->~value_type();
+	}
+	recycle(dead, false);
+	if (m_reaper)
+	{
+		std::vector< Dead > done = m_reaper->finish();
+		recycle(done, false);
+	}
+
+	for (Node* curr = m_front; curr != m_end; curr = curr->m_next)
 	{
-		erase(begin());
+		curr->m_value->~value_type();
 	}
 
-	if (!m_list.empty())
+	for (auto node = m_list.front(); node; node = node->m_next)
 	{
-		delete m_list.back()->m_value;
-		m_list.pop_back();
+		delete node->m_value;
 	}
 
-	m_block_capacity = 64;
+	m_list.clear();
+	m_stack.clear();
+	for (auto& bucket : m_buckets)
+	{
+		bucket.clear();
+	}
+	m_bucket_index.clear();
+	m_free_index.clear();
+	m_blocks.clear();
+	m_occupancy.clear();
+	m_size = 0;
+	m_capacity = 0;
+	m_marks.clear();
+	m_published.store(0, std::memory_order_release);
 	m_front = m_end;
+	m_end->m_prev = nullptr;
 }
 
 template< typename T >
@@ -391,10 +959,25 @@ void BucketStorage< T >::swap(BucketStorage& other) noexcept
 	using std::swap;
 	swap(m_block_capacity, other.m_block_capacity);
 	swap(m_size, other.m_size);
+	swap(m_capacity, other.m_capacity);
 	swap(m_front, other.m_front);
 	swap(m_end, other.m_end);
 	m_list.swap(other.m_list);
 	m_stack.swap(other.m_stack);
+	m_blocks.swap(other.m_blocks);
+	m_occupancy.swap(other.m_occupancy);
+	swap(m_append_only, other.m_append_only);
+	swap(m_preparer, other.m_preparer);
+	swap(m_deferred, other.m_deferred);
+	m_dead.swap(other.m_dead);
+	swap(m_reaper, other.m_reaper);
+	swap(m_policy, other.m_policy);
+	m_buckets.swap(other.m_buckets);
+	m_bucket_index.swap(other.m_bucket_index);
+	m_free_index.swap(other.m_free_index);
+	swap(m_next_serial, other.m_next_serial);
+	m_marks.swap(other.m_marks);
+	m_published.store(other.m_published.exchange(m_published.load(std::memory_order_relaxed), std::memory_order_acq_rel), std::memory_order_release);
 }
 
 template< typename T >
@@ -433,168 +1016,1370 @@ typename BucketStorage< T >::const_iterator BucketStorage< T >::cend() noexcept
 	return const_iterator(m_end, empty() ? nullptr : m_list.back()->m_value);
 }
 
+template< typename T >
+auto BucketStorage< T >::view() noexcept
+{
+	return std::ranges::subrange< iterator, sentinel, std::ranges::subrange_kind::sized >(begin(), sentinel{ m_end }, m_size);
+}
+
+template< typename T >
+auto BucketStorage< T >::view() const noexcept
+{
+	return std::ranges::subrange< const_iterator, sentinel, std::ranges::subrange_kind::sized >(begin(), sentinel{ m_end }, m_size);
+}
+
 template< typename T >
 typename BucketStorage< T >::iterator BucketStorage< T >::get_to_distance(iterator it, difference_type distance)
 {
-	if (distance >= 0)
+	if (-static_cast< difference_type >(m_block_capacity) <= distance && distance <= static_cast< difference_type >(m_block_capacity))
 	{
-		for (difference_type i = 0; i < distance; ++i)
+		for (; distance > 0; --distance)
 		{
 			++it;
 		}
-	}
-	else
-	{
-		for (difference_type i = -distance; i > 0; --i)
+		for (; distance < 0; ++distance)
 		{
 			--it;
 		}
+		return it;
 	}
-	return it;
-}
-
-// BSITERATOR IMPLEMENTATION
 
-template< typename T >
-template< typename U >
-BucketStorage< T >::BSIterator< U >::BSIterator(const iterator& other) : m_node(other.node()), m_block(other.block())
-{
+	const difference_type target = static_cast< difference_type >(index_of(it)) + distance;
+	if (target < 0)
+	{
+		throw std::out_of_range("Attempt to move iterator before the beginning of the container.");
+	}
+	return nth(target);
 }
 
 template< typename T >
-template< typename U >
-BucketStorage< T >::BSIterator< U >::BSIterator(value_type node, Block* block) : m_node(node), m_block(block)
+typename BucketStorage< T >::difference_type BucketStorage< T >::distance(const_iterator first, const_iterator last) const
 {
+	return static_cast< difference_type >(index_of(last)) - static_cast< difference_type >(index_of(first));
 }
 
 template< typename T >
-template< typename U >
-typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator=(const iterator& other)
+template< typename F >
+F BucketStorage< T >::for_each(F f, const size_type prefetch_distance)
 {
-	if (*this != other)
+	Node* ahead = m_front;
+	for (size_type i = 0; i < prefetch_distance && ahead != m_end; ++i)
 	{
-		m_node = other.m_node;
-		m_block = other.m_block;
+		ahead = ahead->m_next;
 	}
-	return *this;
+
+	for (Node* curr = m_front; curr != m_end; curr = curr->m_next)
+	{
+		if (ahead != m_end)
+		{
+			detail::prefetch(ahead->m_next);
+			detail::prefetch(ahead->m_value, sizeof(value_type));
+			ahead = ahead->m_next;
+		}
+		f(*curr->m_value);
+	}
+	return f;
 }
 
 template< typename T >
-template< typename U >
-typename BucketStorage< T >::template BSIterator< U > BucketStorage< T >::BSIterator< U >::operator++(int)
+template< typename F >
+F BucketStorage< T >::for_each(F f, const size_type prefetch_distance) const
 {
-	BSIterator temp = *this;
-	++*this;
-	return temp;
+	const_cast< BucketStorage* >(this)->for_each([&f](reference value) { f(static_cast< const_reference >(value)); }, prefetch_distance);
+	return f;
 }
 
 template< typename T >
-template< typename U >
-typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator++()
+std::vector< typename BucketStorage< T >::Block* > BucketStorage< T >::block_list() const
 {
-	if (!(m_node && m_block))
+	std::vector< Block* > blocks;
+	blocks.reserve(m_list.size());
+	for (auto node = m_list.front(); node; node = node->m_next)
 	{
-		throw std::runtime_error("Attempt to increment uninitialized iterator.");
+		blocks.push_back(node->m_value);
 	}
+	return blocks;
+}
 
-	if (m_node->m_next && !m_node->m_next->m_next)
+template< typename T >
+template< typename F >
+void BucketStorage< T >::visit_block(Block* block, F& f)
+{
+	for (Node* curr = block->m_first; curr; curr = curr == block->m_last ? nullptr : curr->m_next)
 	{
-		m_node = m_node->m_next;
-		return *this;
+		f(*curr->m_value);
 	}
+}
 
-	if (m_node->m_next)
+template< typename T >
+std::vector< typename BucketStorage< T >::size_type > BucketStorage< T >::block_weights(const std::vector< Block* >& blocks)
+{
+	std::vector< size_type > weights;
+	weights.reserve(blocks.size());
+	for (Block* block : blocks)
+	{
+		weights.push_back(block->m_size);
+	}
+	return weights;
+}
+
+template< typename T >
+template< typename F >
+void BucketStorage< T >::parallel_for_each(F f, const size_type threads, ParallelStats* stats)
+{
+	const std::vector< Block* > blocks = block_list();
+	detail::run_stealing(
+		block_weights(blocks),
+		detail::worker_count(threads, blocks.size()),
+		[&](size_type, const size_type index) { visit_block(blocks[index], f); },
+		stats);
+}
+
+template< typename T >
+template< typename F >
+void BucketStorage< T >::parallel_for_each(F f, const size_type threads, ParallelStats* stats) const
+{
+	const_cast< BucketStorage* >(this)->parallel_for_each([&f](reference value) { f(static_cast< const_reference >(value)); }, threads, stats);
+}
+
+template< typename T >
+template< typename R, typename BinaryOp >
+R BucketStorage< T >::parallel_reduce(R init, BinaryOp op, const size_type threads, const bool deterministic, ParallelStats* stats) const
+{
+	const std::vector< Block* > blocks = block_list();
+	const size_type workers = detail::worker_count(threads, blocks.size());
+	std::vector< std::optional< R > > partials(deterministic ? blocks.size() : workers);
+
+	detail::run_stealing(
+		block_weights(blocks),
+		workers,
+		[&](const size_type worker, const size_type index)
+		{
+			std::optional< R >& local = partials[deterministic ? index : worker];
+			auto fold = [&local, &op](const_reference value)
+			{
+				if (local)
+				{
+					local = op(std::move(*local), value);
+				}
+				else
+				{
+					local.emplace(value);
+				}
+			};
+			visit_block(blocks[index], fold);
+		},
+		stats);
+
+	for (auto& partial : partials)
+	{
+		if (partial)
+		{
+			init = op(std::move(init), std::move(*partial));
+		}
+	}
+	return init;
+}
+
+template< typename T >
+template< typename F >
+void BucketStorage< T >::parallel_transform_inplace(F f, const size_type threads, ParallelStats* stats)
+{
+	parallel_for_each([&f](reference value) { value = f(std::as_const(value)); }, threads, stats);
+}
+
+template< typename T >
+template< std::random_access_iterator It >
+void BucketStorage< T >::assign(It first, It last, const size_type threads)
+{
+	clear();
+	const auto count = static_cast< size_type >(last - first);
+	const size_type block_count = (count + m_block_capacity - 1) / m_block_capacity;
+	std::vector< Block* > blocks;
+	blocks.reserve(block_count);
+
+	try
+	{
+		for (size_type i = 0; i < block_count; ++i)
+		{
+			blocks.push_back(push_block());
+		}
+
+		// Every block's position is known up front, so workers construct disjoint blocks and only the links between
+		// blocks are left for the stitching pass below.
+		const size_type workers = detail::worker_count(threads, block_count);
+		detail::run_parallel(
+			workers,
+			[&](const size_type worker)
+			{
+				for (size_type i = worker * block_count / workers; i < (worker + 1) * block_count / workers; ++i)
+				{
+					const size_type offset = i * m_block_capacity;
+					const size_type size = count - offset < m_block_capacity ? count - offset : m_block_capacity;
+					fill_block(blocks[i], first + static_cast< std::iter_difference_t< It > >(offset), size);
+				}
+			});
+	} catch (...)
 	{
-		m_node = m_node->m_next;
-		Node* curr_block = m_block->m_values;
-		if (m_node->m_next && !(curr_block <= m_node && m_node <= curr_block + m_block->m_block_capacity))
+		for (Block* block : blocks)
 		{
-			m_block = m_block->m_node->m_next->m_value;
+			for (size_type i = 0; i < block->m_used; ++i)
+			{
+				block->m_data[i].~value_type();
+			}
 		}
+		clear();
+		throw;
+	}
+
+	std::vector< size_type > sizes;
+	sizes.reserve(block_count);
+	Node* prev = nullptr;
+	for (Block* block : blocks)
+	{
+		block->m_first->m_prev = prev;
+		if (prev)
+		{
+			prev->m_next = block->m_first;
+		}
+		else
+		{
+			m_front = block->m_first;
+		}
+		prev = block->m_last;
+		sizes.push_back(block->m_size);
+		refresh_free(block);
+	}
+	if (prev)
+	{
+		prev->m_next = m_end;
+		m_end->m_prev = prev;
+	}
+
+	m_occupancy.assign(sizes);
+	m_size = count;
+	m_published.store(m_size, std::memory_order_release);
+}
+
+template< typename T >
+template< typename Relocate >
+typename BucketStorage< T >::size_type BucketStorage< T >::compact_step(const size_type budget, Relocate relocate)
+{
+	if (m_append_only)
+	{
+		throw std::runtime_error("Attempt to compact append-only storage.");
+	}
+	if (!m_marks.empty())
+	{
+		throw std::runtime_error("Attempt to compact storage with an active mark.");
+	}
+
+	// Both ends come from the occupancy buckets, so each move costs O(log64 capacity) whatever the block count.
+	size_type moved = 0;
+	while (moved < budget && m_stack.size() > 1)
+	{
+		Block* source = m_buckets[m_bucket_index.first()].front()->m_value;
+		Block* target = m_buckets[m_bucket_index.last()].back()->m_value;
+		if (source == target)
+		{
+			break;
+		}
+
+		// Drain the sparsest block into the densest one with room; erase frees the source once it is empty.
+		bool drained = false;
+		while (moved < budget && target->m_free_node && !drained)
+		{
+			Node* node = source->m_first;
+			value_type* old = node->m_value;
+			iterator it = emplace_in(target, std::move(*old));
+			relocate(static_cast< const value_type* >(old), it.node()->m_value);
+			drained = source->m_size == 1;
+			erase(const_iterator(node, source));
+			++moved;
+		}
+	}
+	return moved;
+}
+
+template< typename T >
+void BucketStorage< T >::splice(BucketStorage&& other)
+{
+	if (this == &other)
+	{
+		return;
+	}
+	if (m_block_capacity != other.m_block_capacity)
+	{
+		throw std::invalid_argument("Attempt to splice storages with different block capacities.");
+	}
+	if (m_append_only || other.m_append_only)
+	{
+		throw std::runtime_error("Attempt to splice append-only storage.");
+	}
+
+	// Pending destructors point into other's blocks and must not outlive its queue.
+	other.collect();
+	if (other.m_list.empty())
+	{
+		return;
+	}
+	adopt_blocks(other, other.m_list.front());
+}
+
+template< typename T >
+BucketStorage< T > BucketStorage< T >::split(const_iterator pos)
+{
+	if (!pos.node())
+	{
+		throw std::runtime_error("Attempt to split by uninitialized iterator.");
+	}
+	if (m_append_only)
+	{
+		throw std::runtime_error("Attempt to split append-only storage.");
+	}
+
+	BucketStorage result(m_block_capacity);
+	result.set_slot_policy(m_policy);
+	if (pos.node() == m_end)
+	{
+		return result;
+	}
+	collect();
+
+	// The boundary block keeps the elements before pos; only the ones from pos onward are moved out of it.
+	Block* boundary = pos.block();
+	auto first = boundary->m_node;
+	if (pos.node() != boundary->m_first)
+	{
+		for (Node* curr = pos.node(); curr;)
+		{
+			Node* next = curr == boundary->m_last ? nullptr : curr->m_next;
+			result.insert(std::move(*curr->m_value));
+			erase(const_iterator(curr, boundary));
+			curr = next;
+		}
+		first = first->m_next;
+	}
+
+	if (first)
+	{
+		result.adopt_blocks(*this, first);
+	}
+	return result;
+}
+
+template< typename T >
+template< typename F >
+void BucketStorage< T >::visit_runs(Block* block, F f)
+{
+	// Adjacent nodes own adjacent elements, so a run of consecutive nodes in traversal order is one contiguous array.
+	for (Node* curr = block->m_first; curr;)
+	{
+		Node* last = curr;
+		while (last != block->m_last && last->m_next == last + 1)
+		{
+			++last;
+		}
+		f(curr->m_value, static_cast< size_type >(last - curr) + 1);
+		curr = last == block->m_last ? nullptr : last->m_next;
+	}
+}
+
+template< typename T >
+template< bool Move >
+void BucketStorage< T >::append_run(std::vector< value_type >& out, value_type* first, size_type count)
+{
+	// Trivially copyable runs go in as one block copy; anything else is constructed in place, which needs no assignment.
+	// Moving falls back to copying when the move may throw, so a failure leaves the source untouched.
+	if constexpr (std::is_trivially_copyable_v< value_type > && std::is_copy_assignable_v< value_type >)
+	{
+		out.insert(out.end(), first, first + count);
 	}
 	else
 	{
-		throw std::runtime_error("Attempt to increment past the end of the container.");
+		for (; count > 0; --count, ++first)
+		{
+			if constexpr (Move)
+			{
+				out.emplace_back(std::move_if_noexcept(*first));
+			}
+			else
+			{
+				out.emplace_back(static_cast< const_reference >(*first));
+			}
+		}
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::drain_to(std::vector< value_type >& out)
+{
+	if (m_append_only)
+	{
+		throw std::runtime_error("Attempt to drain append-only storage.");
+	}
+
+	collect();
+	out.reserve(out.size() + m_size);
+	while (!m_list.empty())
+	{
+		// Each block is detached from the front once its elements are out, so at most one drained block is held.
+		// A block is destroyed only after all of it has been transferred; if a copy throws, the block stays whole in the
+		// storage. Only a move-only type whose move throws can leave moved-from elements behind.
+		Block* block = m_list.front()->m_value;
+		const size_type before = out.size();
+		try
+		{
+			visit_runs(block, [&out](value_type* data, const size_type count) { append_run< true >(out, data, count); });
+		} catch (...)
+		{
+			while (out.size() > before)
+			{
+				out.pop_back();
+			}
+			throw;
+		}
+		visit_runs(block, [](value_type* data, const size_type count) { std::destroy_n(data, count); });
+
+		if (block->m_last)
+		{
+			m_front = block->m_last->m_next;
+			m_front->m_prev = nullptr;
+		}
+		m_size -= block->m_size;
+		m_occupancy.add(block->m_index, -static_cast< std::ptrdiff_t >(block->m_size));
+		block->m_size = 0;
+		release_block(block);
+	}
+	m_published.store(0, std::memory_order_release);
+}
+
+template< typename T >
+std::vector< typename BucketStorage< T >::value_type > BucketStorage< T >::to_vector() const
+{
+	std::vector< value_type > result;
+	result.reserve(m_size);
+	for (auto node = m_list.front(); node; node = node->m_next)
+	{
+		visit_runs(node->m_value, [&result](value_type* data, const size_type count) { append_run< false >(result, data, count); });
+	}
+	return result;
+}
+
+template< typename T >
+template< typename Deleter >
+void BucketStorage< T >::adopt(value_type* buffer, const size_type n, Deleter deleter)
+{
+	// The storage destroys adopted elements like its own; deleter only releases the memory, after the last one is gone.
+	// Until the blocks are linked in, the owner also destroys the n elements, so every failure path destroys them before
+	// the buffer is released. That includes a failed control block allocation.
+	struct Release
+	{
+		Deleter m_deleter;
+		size_type m_count;
+
+		void operator()(value_type* data)
+		{
+			std::destroy_n(data, m_count);
+			m_deleter(data);
+		}
+	};
+
+	// Everything that allocates happens here, so the linking below cannot fail halfway.
+	std::shared_ptr< void > owner;
+	std::vector< Block* > blocks;
+	detail::List< Block* > staged;
+	try
+	{
+		owner = std::shared_ptr< void >(buffer, Release{ std::move(deleter), n });
+		blocks.reserve((n + m_block_capacity - 1) / m_block_capacity);
+		for (size_type offset = 0; offset < n; offset += m_block_capacity)
+		{
+			const size_type count = n - offset < m_block_capacity ? n - offset : m_block_capacity;
+			blocks.push_back(new Block(count, buffer + offset, owner));
+			staged.push_back(blocks.back());
+		}
+		m_blocks.reserve(m_blocks.size() + blocks.size());
+		m_occupancy.reserve(m_occupancy.size() + blocks.size());
+		if (m_policy == SlotPolicy::lowest_address_first)
+		{
+			m_free_index.resize(m_blocks.size() + blocks.size());
+		}
+	} catch (...)
+	{
+		for (Block* block : blocks)
+		{
+			delete block;
+		}
+		throw;
+	}
+	std::get_deleter< Release >(owner)->m_count = 0;
+
+	auto node = staged.front();
+	if (node)
+	{
+		m_list.splice_back(staged, node);
+	}
+
+	Node* prev = m_end->m_prev;
+	for (Block* block : blocks)
+	{
+		for (size_type i = 0; i < block->m_block_capacity; ++i)
+		{
+			Node* node = block->m_values + i;
+			node->m_value = block->m_data + i;
+			node->m_prev = i > 0 ? node - 1 : prev;
+			node->m_next = node + 1;
+		}
+		block->m_used = block->m_block_capacity;
+		block->m_size = block->m_block_capacity;
+		block->m_first = block->m_values;
+		block->m_last = block->m_values + block->m_block_capacity - 1;
+		if (prev)
+		{
+			prev->m_next = block->m_first;
+		}
+		else
+		{
+			m_front = block->m_first;
+		}
+		prev = block->m_last;
+
+		// Adopted blocks are exactly full, so they never enter the free-slot registry here.
+		block->m_index = m_blocks.size();
+		block->m_serial = m_next_serial++;
+		block->m_node = node;
+		node = node->m_next;
+		m_blocks.push_back(block);
+		m_occupancy.push_back(block->m_size);
+		m_size += block->m_size;
+		m_capacity += block->m_block_capacity;
+	}
+	if (prev)
+	{
+		prev->m_next = m_end;
+		m_end->m_prev = prev;
+	}
+	m_published.store(m_size, std::memory_order_release);
+}
+
+template< typename T >
+void BucketStorage< T >::adopt_blocks(BucketStorage& from, typename detail::List< Block* >::NodeType* first)
+{
+	// Blocks are moved from the tail of from's list, so their elements form the tail of its traversal order.
+	Node* head = nullptr;
+	for (auto node = first; node && !head; node = node->m_next)
+	{
+		head = node->m_value->m_first;
+	}
+	if (head)
+	{
+		Node* tail = from.m_end->m_prev;
+		if (head->m_prev)
+		{
+			head->m_prev->m_next = from.m_end;
+		}
+		else
+		{
+			from.m_front = from.m_end;
+		}
+		from.m_end->m_prev = head->m_prev;
+
+		head->m_prev = m_end->m_prev;
+		if (head->m_prev)
+		{
+			head->m_prev->m_next = head;
+		}
+		else
+		{
+			m_front = head;
+		}
+		tail->m_next = m_end;
+		m_end->m_prev = tail;
+	}
+
+	std::vector< Block* > blocks;
+	for (auto node = first; node; node = node->m_next)
+	{
+		Block* block = node->m_value;
+		if (block->m_free_node)
+		{
+			from.unregister_free(block);
+		}
+		block->m_index = m_blocks.size() + blocks.size();
+		block->m_serial = m_next_serial++;
+		blocks.push_back(block);
+	}
+	m_list.splice_back(from.m_list, first);
+
+	for (Block* block : blocks)
+	{
+		m_blocks.push_back(block);
+		m_occupancy.push_back(block->m_size);
+		m_size += block->m_size;
+		from.m_size -= block->m_size;
+		m_capacity += block->m_block_capacity;
+		from.m_capacity -= block->m_block_capacity;
+	}
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.resize(m_blocks.size());
+	}
+	for (Block* block : blocks)
+	{
+		refresh_free(block);
+	}
+
+	from.reindex();
+	from.m_published.store(from.m_size, std::memory_order_release);
+	m_published.store(m_size, std::memory_order_release);
+}
+
+template< typename T >
+void BucketStorage< T >::relink_in_address_order() noexcept
+{
+	// Append-only storage never reuses slots, so its links already follow address order and readers may be walking them.
+	if (m_append_only)
+	{
+		return;
+	}
+
+	// Live nodes are exactly those holding a value; slots past m_used were never handed out.
+	Node* prev = nullptr;
+	for (auto node = m_list.front(); node; node = node->m_next)
+	{
+		Block* block = node->m_value;
+		block->m_first = nullptr;
+		for (Node* curr = block->m_values; curr != block->m_values + block->m_used; ++curr)
+		{
+			if (!curr->m_value)
+			{
+				continue;
+			}
+
+			curr->m_prev = prev;
+			if (prev)
+			{
+				prev->m_next = curr;
+			}
+			else
+			{
+				m_front = curr;
+			}
+			if (!block->m_first)
+			{
+				block->m_first = curr;
+			}
+			block->m_last = curr;
+			prev = curr;
+		}
+	}
+
+	if (prev)
+	{
+		prev->m_next = m_end;
+	}
+	m_end->m_prev = prev;
+}
+
+template< typename T >
+template< typename KeyFn, typename Relocate >
+void BucketStorage< T >::reorder_by(KeyFn key, Relocate relocate)
+{
+	if (m_append_only)
+	{
+		throw std::runtime_error("Attempt to reorder append-only storage.");
+	}
+
+	using Key = std::remove_cvref_t< std::invoke_result_t< KeyFn&, const_reference > >;
+	std::vector< std::pair< Key, Node* > > order;
+	order.reserve(m_size);
+	for (Node* curr = m_front; curr != m_end; curr = curr->m_next)
+	{
+		order.emplace_back(key(static_cast< const_reference >(*curr->m_value)), curr);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	// A fresh storage fills its blocks back to back, so each key ends up in a contiguous run of slots.
+	BucketStorage temp = BucketStorage(m_block_capacity);
+	temp.set_slot_policy(m_policy);
+	for (auto& entry : order)
+	{
+		value_type* old = entry.second->m_value;
+		iterator it = temp.insert(std::move(*old));
+		relocate(static_cast< const value_type* >(old), it.node()->m_value);
+	}
+
+	collect();
+	temp.m_deferred = m_deferred;
+	temp.m_preparer.swap(m_preparer);
+	temp.m_reaper.swap(m_reaper);
+	swap(temp);
+	m_published.store(m_size, std::memory_order_release);
+}
+
+template< typename T >
+template< typename It >
+void BucketStorage< T >::fill_block(Block* block, It source, const size_type count)
+{
+	try
+	{
+		for (; block->m_used < count; ++block->m_used)
+		{
+			Node* node = block->m_values + block->m_used;
+			new (block->m_data + block->m_used) value_type(source[static_cast< std::iter_difference_t< It > >(block->m_used)]);
+			node->m_value = block->m_data + block->m_used;
+			if (block->m_used > 0)
+			{
+				node->m_prev = node - 1;
+				node[-1].m_next = node;
+			}
+		}
+	} catch (...)
+	{
+		for (size_type i = 0; i < block->m_used; ++i)
+		{
+			block->m_data[i].~value_type();
+		}
+		block->m_used = 0;
+		throw;
+	}
+
+	block->m_size = count;
+	block->m_first = block->m_values;
+	block->m_last = block->m_values + count - 1;
+}
+
+template< typename T >
+void BucketStorage< T >::start_block_preparer(const size_type ready_blocks)
+{
+	if (ready_blocks == 0)
+	{
+		throw std::invalid_argument("Block preparer needs at least one handoff slot.");
+	}
+	m_preparer.reset();
+	m_preparer = std::make_unique< BlockPreparer >(m_block_capacity, ready_blocks);
+}
+
+template< typename T >
+void BucketStorage< T >::stop_block_preparer() noexcept
+{
+	m_preparer.reset();
+}
+
+template< typename T >
+void BucketStorage< T >::set_deferred_destruction(const bool enabled, const bool background)
+{
+	collect();
+	m_reaper.reset();
+	m_deferred = enabled;
+	if (enabled && background)
+	{
+		m_reaper = std::make_unique< Reaper >();
+	}
+}
+
+template< typename T >
+bool BucketStorage< T >::deferred_destruction() const noexcept
+{
+	return m_deferred;
+}
+
+template< typename T >
+void BucketStorage< T >::collect()
+{
+	std::vector< Dead > dead;
+	dead.swap(m_dead);
+	for (const Dead& entry : dead)
+	{
+		entry.element()->~value_type();
+	}
+	recycle(dead, true);
+
+	if (m_reaper)
+	{
+		std::vector< Dead > done = m_reaper->finish();
+		recycle(done, true);
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::recycle(std::vector< Dead >& dead, const bool reuse)
+{
+	for (const Dead& entry : dead)
+	{
+		Block* block = entry.m_block;
+		--block->m_pending;
+		if (!block->m_node)
+		{
+			if (block->m_pending == 0)
+			{
+				delete block;
+			}
+		}
+		else if (reuse)
+		{
+			block->m_stack.push_back(entry.m_node);
+			refresh_free(block);
+		}
+	}
+	dead.clear();
+}
+
+template< typename T >
+void BucketStorage< T >::set_slot_policy(const SlotPolicy policy)
+{
+	std::vector< Block* > blocks;
+	blocks.reserve(m_stack.size());
+	while (!m_stack.empty())
+	{
+		blocks.push_back(m_stack.front()->m_value);
+		unregister_free(blocks.back());
+	}
+
+	m_policy = policy;
+	m_free_index.clear();
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.resize(m_blocks.size());
+	}
+
+	for (Block* block : blocks)
+	{
+		register_free(block);
+	}
+}
+
+template< typename T >
+typename BucketStorage< T >::SlotPolicy BucketStorage< T >::slot_policy() const noexcept
+{
+	return m_policy;
+}
+
+template< typename T >
+void BucketStorage< T >::refresh_free(Block* block)
+{
+	const bool room = block->m_size + block->m_pending < block->m_block_capacity;
+	if (!block->m_free_node)
+	{
+		if (room)
+		{
+			register_free(block);
+		}
+		return;
+	}
+	if (!room)
+	{
+		unregister_free(block);
+		return;
+	}
+
+	// A size change relinks the block's bucket node and leaves m_stack alone.
+	if (block->m_bucket != block->m_size)
+	{
+		detail::List< Block* >& from = m_buckets[block->m_bucket];
+		m_buckets[block->m_size].transfer_back(from, block->m_bucket_node);
+		if (from.empty())
+		{
+			m_bucket_index.reset(block->m_bucket);
+		}
+		m_bucket_index.set(block->m_size);
+		block->m_bucket = block->m_size;
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::register_free(Block* block)
+{
+	// Every block with room is filed by its size, whatever the policy: fullest-first and compaction pick from the buckets.
+	if (m_buckets.size() < m_block_capacity)
+	{
+		m_buckets.resize(m_block_capacity);
+		m_bucket_index.resize(m_block_capacity);
+	}
+	m_buckets[block->m_size].push_back(block);
+	m_stack.push_back(block);
+	block->m_bucket_node = m_buckets[block->m_size].back();
+	block->m_free_node = m_stack.back();
+	block->m_bucket = block->m_size;
+	m_bucket_index.set(block->m_bucket);
+
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.set(block->m_index);
+	}
+}
+
+template< typename T >
+void BucketStorage< T >::unregister_free(Block* block) noexcept
+{
+	m_stack.erase(block->m_free_node);
+	block->m_free_node = nullptr;
+
+	detail::List< Block* >& bucket = m_buckets[block->m_bucket];
+	bucket.erase(block->m_bucket_node);
+	block->m_bucket_node = nullptr;
+	if (bucket.empty())
+	{
+		m_bucket_index.reset(block->m_bucket);
+	}
+
+	if (m_policy == SlotPolicy::lowest_address_first)
+	{
+		m_free_index.reset(block->m_index);
+	}
+}
+
+template< typename T >
+typename BucketStorage< T >::Block* BucketStorage< T >::pick_free() const noexcept
+{
+	switch (m_policy)
+	{
+	case SlotPolicy::fullest_first:
+		return m_buckets[m_bucket_index.last()].back()->m_value;
+	case SlotPolicy::lowest_address_first:
+		return m_blocks[m_free_index.first()];
+	default:
+		return m_stack.back()->m_value;
+	}
+}
+
+template< typename T >
+bool BucketStorage< T >::appending() const noexcept
+{
+	return m_append_only || !m_marks.empty();
+}
+
+template< typename T >
+bool BucketStorage< T >::within(const Mark& mark, const Block* block) noexcept
+{
+	// Blocks created after the mark and the mark's boundary block are exactly the ones rollback trims.
+	return block->m_serial >= mark.m_next_serial || block->m_serial == mark.m_serial;
+}
+
+template< typename T >
+typename BucketStorage< T >::Mark BucketStorage< T >::mark()
+{
+	// Until rolled back, inserts only append, so everything inserted later forms a suffix of blocks and slots.
+	// A back block the enclosing mark would not roll back cannot serve as boundary; the next insert opens a new block.
+	Block* back = m_list.empty() ? nullptr : m_list.back()->m_value;
+	const bool usable = back && (m_marks.empty() || within(m_marks.back(), back));
+	Mark result;
+	result.m_serial = usable ? back->m_serial : m_next_serial;
+	result.m_next_serial = m_next_serial;
+	result.m_used = usable ? back->m_used : 0;
+	result.m_depth = m_marks.size();
+	result.m_id = detail::next_mark_id();
+	m_marks.push_back(result);
+	return result;
+}
+
+template< typename T >
+void BucketStorage< T >::rollback(const Mark& mark)
+{
+	if (mark.m_depth >= m_marks.size() || m_marks[mark.m_depth].m_id != mark.m_id)
+	{
+		throw std::invalid_argument("Attempt to roll back to an inactive mark.");
+	}
+
+	collect();
+	std::vector< Block* > trailing;
+	for (auto node = m_list.back(); node && node->m_value->m_serial >= mark.m_next_serial; node = node->m_prev)
+	{
+		trailing.push_back(node->m_value);
+	}
+
+	// Blocks created after the mark hold the traversal suffix; cut it off in one step, then free them whole.
+	Node* head = nullptr;
+	for (auto it = trailing.rbegin(); it != trailing.rend() && !head; ++it)
+	{
+		head = (*it)->m_first;
+	}
+	if (head)
+	{
+		if (head->m_prev)
+		{
+			head->m_prev->m_next = m_end;
+		}
+		else
+		{
+			m_front = m_end;
+		}
+		m_end->m_prev = head->m_prev;
+	}
+
+	for (Block* block : trailing)
+	{
+		if constexpr (!std::is_trivially_destructible_v< value_type >)
+		{
+			for (Node* curr = block->m_values; curr != block->m_values + block->m_used; ++curr)
+			{
+				if (curr->m_value)
+				{
+					curr->m_value->~value_type();
+				}
+			}
+		}
+		m_size -= block->m_size;
+		m_occupancy.add(block->m_index, -static_cast< std::ptrdiff_t >(block->m_size));
+		block->m_size = 0;
+		release_block(block);
+	}
+
+	// The block that was last at the mark loses only the slots it handed out since.
+	Block* boundary = m_list.empty() ? nullptr : m_list.back()->m_value;
+	if (boundary && boundary->m_serial == mark.m_serial && boundary->m_used > mark.m_used)
+	{
+		for (Node* curr = boundary->m_values + mark.m_used; curr != boundary->m_values + boundary->m_used; ++curr)
+		{
+			if (curr->m_value)
+			{
+				curr->m_value->~value_type();
+				curr->m_value = nullptr;
+				unlink_node(boundary, curr);
+				--boundary->m_size;
+				--m_size;
+				m_occupancy.add(boundary->m_index, -1);
+			}
+		}
+		for (auto node = boundary->m_stack.front(); node;)
+		{
+			auto next = node->m_next;
+			if (node->m_value >= boundary->m_values + mark.m_used)
+			{
+				boundary->m_stack.erase(node);
+			}
+			node = next;
+		}
+		boundary->m_used = mark.m_used;
+
+		if (boundary->m_size == 0)
+		{
+			release_block(boundary);
+		}
+		else
+		{
+			refresh_free(boundary);
+		}
+	}
+
+	m_marks.resize(mark.m_depth);
+	m_published.store(m_size, std::memory_order_release);
+}
+
+// BLOCKPREPARER IMPLEMENTATION
+
+template< typename T >
+BucketStorage< T >::BlockPreparer::BlockPreparer(const size_type block_capacity, const size_type ready) :
+	m_block_capacity(block_capacity), m_ready(ready), m_thread(&BlockPreparer::run, this)
+{
+}
+
+template< typename T >
+BucketStorage< T >::BlockPreparer::~BlockPreparer()
+{
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+
+	for (auto& slot : m_ready)
+	{
+		delete slot.load(std::memory_order_acquire);
+	}
+}
+
+template< typename T >
+typename BucketStorage< T >::Block* BucketStorage< T >::BlockPreparer::take()
+{
+	Block* block = nullptr;
+	for (auto& slot : m_ready)
+	{
+		if (slot.load(std::memory_order_relaxed))
+		{
+			block = slot.exchange(nullptr, std::memory_order_acquire);
+			break;
+		}
+	}
+
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_pending = true;
+	}
+	m_wake.notify_one();
+	return block;
+}
+
+template< typename T >
+void BucketStorage< T >::BlockPreparer::run()
+{
+	std::unique_lock< std::mutex > lock(m_mutex);
+	while (!m_stop)
+	{
+		m_pending = false;
+		lock.unlock();
+		for (auto& slot : m_ready)
+		{
+			if (slot.load(std::memory_order_relaxed))
+			{
+				continue;
+			}
+
+			// An allocation failure leaves the slot empty; the insert path then allocates as usual.
+			Block* block = nullptr;
+			try
+			{
+				block = new Block(m_block_capacity, 0);
+			} catch (...)
+			{
+				break;
+			}
+			detail::prefault(block->m_data, m_block_capacity * sizeof(value_type));
+			slot.store(block, std::memory_order_release);
+		}
+		lock.lock();
+		m_wake.wait(lock, [this] { return m_stop || m_pending; });
+	}
+}
+
+// REAPER IMPLEMENTATION
+
+template< typename T >
+typename BucketStorage< T >::value_type* BucketStorage< T >::Dead::element() const noexcept
+{
+	return m_block->m_data + (m_node - m_block->m_values);
+}
+
+template< typename T >
+BucketStorage< T >::Reaper::Reaper() : m_thread(&Reaper::run, this)
+{
+}
+
+template< typename T >
+BucketStorage< T >::Reaper::~Reaper()
+{
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+template< typename T >
+void BucketStorage< T >::Reaper::submit(std::vector< Dead >& batch)
+{
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		if (m_queue.empty())
+		{
+			m_queue.swap(batch);
+		}
+		else
+		{
+			m_queue.insert(m_queue.end(), batch.begin(), batch.end());
+			batch.clear();
+		}
+	}
+	m_wake.notify_one();
+}
+
+template< typename T >
+std::vector< typename BucketStorage< T >::Dead > BucketStorage< T >::Reaper::take_done()
+{
+	std::vector< Dead > done;
+	std::lock_guard< std::mutex > lock(m_mutex);
+	done.swap(m_done);
+	return done;
+}
+
+template< typename T >
+std::vector< typename BucketStorage< T >::Dead > BucketStorage< T >::Reaper::finish()
+{
+	std::vector< Dead > done;
+	std::unique_lock< std::mutex > lock(m_mutex);
+	m_idle.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+	done.swap(m_done);
+	return done;
+}
+
+template< typename T >
+void BucketStorage< T >::Reaper::run()
+{
+	std::unique_lock< std::mutex > lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+		if (m_queue.empty())
+		{
+			return;
+		}
+
+		std::vector< Dead > batch;
+		batch.swap(m_queue);
+		m_busy = true;
+		lock.unlock();
+		for (const Dead& entry : batch)
+		{
+			entry.element()->~value_type();
+		}
+		lock.lock();
+
+		if (m_done.empty())
+		{
+			m_done.swap(batch);
+		}
+		else
+		{
+			m_done.insert(m_done.end(), batch.begin(), batch.end());
+		}
+		m_busy = false;
+		m_idle.notify_all();
+	}
+}
+
+// BSITERATOR IMPLEMENTATION
+
+template< typename T >
+template< typename U >
+BucketStorage< T >::BSIterator< U >::BSIterator(const iterator& other) : m_node(other.node()), m_block(other.block())
+{
+}
+
+template< typename T >
+template< typename U >
+BucketStorage< T >::BSIterator< U >::BSIterator(Node* node, Block* block) : m_node(node), m_block(block)
+{
+}
+
+template< typename T >
+template< typename U >
+typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator=(const iterator& other)
+{
+	if (*this != other)
+	{
+		m_node = other.m_node;
+		m_block = other.m_block;
 	}
-
 	return *this;
 }
 
 template< typename T >
 template< typename U >
-typename BucketStorage< T >::template BSIterator< U > BucketStorage< T >::BSIterator< U >::operator--(int)
+typename BucketStorage< T >::template BSIterator< U > BucketStorage< T >::BSIterator< U >::operator++(int) noexcept(!detail::checked_iterators)
 {
 	BSIterator temp = *this;
-	--*this;
+	++*this;
 	return temp;
 }
 
 template< typename T >
 template< typename U >
-typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator--()
+typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator++() noexcept(!detail::checked_iterators)
 {
-	if (!(m_node && m_block))
+	if constexpr (detail::checked_iterators)
 	{
-		throw std::runtime_error("Attempt to decrement uninitialized iterator.");
+		check_valid("increment");
+		if (!m_node->m_next)
+		{
+			throw std::runtime_error("Attempt to increment past the end of the container.");
+		}
 	}
 
-	if (!m_node->m_next)
+	if (m_node == m_block->m_last && m_block->m_node->m_next)
 	{
-		m_node = m_node->m_prev;
-		return *this;
+		m_block = m_block->m_node->m_next->m_value;
 	}
+	m_node = m_node->m_next;
+
+	return *this;
+}
+
+template< typename T >
+template< typename U >
+typename BucketStorage< T >::template BSIterator< U > BucketStorage< T >::BSIterator< U >::operator--(int) noexcept(!detail::checked_iterators)
+{
+	BSIterator temp = *this;
+	--*this;
+	return temp;
+}
 
-	if (m_node->m_prev)
+template< typename T >
+template< typename U >
+typename BucketStorage< T >::template BSIterator< U >& BucketStorage< T >::BSIterator< U >::operator--() noexcept(!detail::checked_iterators)
+{
+	if constexpr (detail::checked_iterators)
 	{
-		m_node = m_node->m_prev;
-		Node* curr_block = m_block->m_values;
-		if (!(curr_block <= m_node && m_node <= curr_block + m_block->m_block_capacity))
+		check_valid("decrement");
+		if (!m_node->m_prev)
 		{
-			m_block = m_block->m_node->m_prev->m_value;
+			throw std::runtime_error("Attempt to decrement before the beginning of the container.");
 		}
 	}
-	else
+
+	if (m_node == m_block->m_first && m_block->m_node->m_prev)
 	{
-		throw std::runtime_error("Attempt to decrement before the beginning of the container.");
+		m_block = m_block->m_node->m_prev->m_value;
 	}
+	m_node = m_node->m_prev;
 
 	return *this;
 }
 
 template< typename T >
 template< typename U >
-bool BucketStorage< T >::BSIterator< U >::operator<(const BSIterator& other) const
+bool BucketStorage< T >::BSIterator< U >::operator<(const BSIterator& other) const noexcept(!detail::checked_iterators)
 {
-	if (!(m_node && m_block && other.m_node && other.m_block))
+	if constexpr (detail::checked_iterators)
 	{
-		throw std::runtime_error("Attempt to compare uninitialized iterator.");
+		if (!(m_node && m_block && other.m_node && other.m_block))
+		{
+			throw std::runtime_error("Attempt to compare uninitialized iterator.");
+		}
 	}
 
+	if (m_node == other.m_node || !m_node->m_next)
+	{
+		return false;
+	}
+	if (!other.m_node->m_next)
+	{
+		return true;
+	}
 	if (m_block->m_index != other.m_block->m_index)
 	{
 		return m_block->m_index < other.m_block->m_index;
 	}
 
-	return m_node < other.m_node;
+	for (Node* curr = m_node; curr != m_block->m_last; curr = curr->m_next)
+	{
+		if (curr->m_next == other.m_node)
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 template< typename T >
 template< typename U >
-bool BucketStorage< T >::BSIterator< U >::operator>(const BSIterator& other) const
+bool BucketStorage< T >::BSIterator< U >::operator>(const BSIterator& other) const noexcept(!detail::checked_iterators)
 {
 	return other < *this;
 }
 
 template< typename T >
 template< typename U >
-bool BucketStorage< T >::BSIterator< U >::operator<=(const BSIterator& other) const
+bool BucketStorage< T >::BSIterator< U >::operator<=(const BSIterator& other) const noexcept(!detail::checked_iterators)
 {
 	return !(*this > other);
 }
 
 template< typename T >
 template< typename U >
-bool BucketStorage< T >::BSIterator< U >::operator>=(const BSIterator& other) const
+bool BucketStorage< T >::BSIterator< U >::operator>=(const BSIterator& other) const noexcept(!detail::checked_iterators)
 {
 	return !(*this < other);
 }
@@ -608,29 +2393,40 @@ bool BucketStorage< T >::BSIterator< U >::operator==(const BSIterator& other) co
 
 template< typename T >
 template< typename U >
-typename BucketStorage< T >::template BSIterator< U >::pointer BucketStorage< T >::BSIterator< U >::operator->()
+bool BucketStorage< T >::BSIterator< U >::operator==(const BSSentinel& other) const noexcept
+{
+	return m_node == other.m_end;
+}
+
+template< typename T >
+template< typename U >
+typename BucketStorage< T >::template BSIterator< U >::pointer BucketStorage< T >::BSIterator< U >::operator->() const noexcept(!detail::checked_iterators)
 {
-	if (m_node == nullptr)
+	if constexpr (detail::checked_iterators)
 	{
-		throw std::runtime_error("Attempt to access uninitialized iterator.");
+		check_valid("access");
 	}
 	return m_node->m_value;
 }
 
 template< typename T >
 template< typename U >
-typename BucketStorage< T >::template BSIterator< U >::reference BucketStorage< T >::BSIterator< U >::operator*()
+typename BucketStorage< T >::template BSIterator< U >::reference BucketStorage< T >::BSIterator< U >::operator*() const noexcept(!detail::checked_iterators)
 {
-	if (m_node == nullptr)
+	if constexpr (detail::checked_iterators)
 	{
-		throw std::runtime_error("Attempt to dereference uninitialized iterator.");
+		check_valid("dereference");
+		if (!m_node->m_next)
+		{
+			throw std::runtime_error("Attempt to dereference the end iterator.");
+		}
 	}
 	return *m_node->m_value;
 }
 
 template< typename T >
 template< typename U >
-typename BucketStorage< T >::template BSIterator< U >::value_type BucketStorage< T >::BSIterator< U >::node() const noexcept
+typename BucketStorage< T >::Node* BucketStorage< T >::BSIterator< U >::node() const noexcept
 {
 	return m_node;
 }
@@ -642,6 +2438,20 @@ typename BucketStorage< T >::Block* BucketStorage< T >::BSIterator< U >::block()
 	return m_block;
 }
 
+template< typename T >
+template< typename U >
+void BucketStorage< T >::BSIterator< U >::check_valid(const char* operation) const
+{
+	if (!(m_node && m_block))
+	{
+		throw std::runtime_error(std::string("Attempt to ") + operation + " uninitialized iterator.");
+	}
+	if (!m_node->m_value && m_node->m_next)
+	{
+		throw std::runtime_error(std::string("Attempt to ") + operation + " iterator to an erased element.");
+	}
+}
+
 // LIST IMPLEMENTATION
 
 template< typename T >
@@ -752,6 +2562,76 @@ void detail::List< T >::pop_back()
 	erase(m_tail);
 }
 
+template< typename T >
+void detail::List< T >::splice_back(List& other, NodeType* first) noexcept
+{
+	NodeType* last = other.m_tail;
+	size_type count = 0;
+	for (NodeType* curr = first; curr; curr = curr->m_next)
+	{
+		++count;
+	}
+
+	if (first->m_prev)
+	{
+		other.m_tail = first->m_prev;
+		other.m_tail->m_next = nullptr;
+	}
+	else
+	{
+		other.m_head = nullptr;
+		other.m_tail = nullptr;
+	}
+	other.m_size -= count;
+
+	first->m_prev = m_tail;
+	if (m_tail)
+	{
+		m_tail->m_next = first;
+	}
+	else
+	{
+		m_head = first;
+	}
+	m_tail = last;
+	m_size += count;
+}
+
+template< typename T >
+void detail::List< T >::transfer_back(List& other, NodeType* node) noexcept
+{
+	if (node->m_prev)
+	{
+		node->m_prev->m_next = node->m_next;
+	}
+	else
+	{
+		other.m_head = node->m_next;
+	}
+	if (node->m_next)
+	{
+		node->m_next->m_prev = node->m_prev;
+	}
+	else
+	{
+		other.m_tail = node->m_prev;
+	}
+	--other.m_size;
+
+	node->m_next = nullptr;
+	node->m_prev = m_tail;
+	if (m_tail)
+	{
+		m_tail->m_next = node;
+	}
+	else
+	{
+		m_head = node;
+	}
+	m_tail = node;
+	++m_size;
+}
+
 template< typename T >
 typename detail::List< T >::NodeType* detail::List< T >::front() const noexcept
 {
@@ -793,3 +2673,384 @@ void detail::List< T >::swap(List& other) noexcept
 	swap(m_head, other.m_head);
 	swap(m_tail, other.m_tail);
 }
+
+// DETAIL IMPLEMENTATION
+
+inline void detail::prefetch(const void* address, const size_type bytes) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	const char* line = static_cast< const char* >(address);
+	const size_type count = bytes < cache_line_size * prefetch_lines ? bytes : cache_line_size * prefetch_lines;
+	for (size_type offset = 0; offset < count; offset += cache_line_size)
+	{
+		__builtin_prefetch(line + offset);
+	}
+#else
+	(void)address;
+	(void)bytes;
+#endif
+}
+
+inline void detail::prefault(void* address, const size_type bytes) noexcept
+{
+	volatile unsigned char* page = static_cast< unsigned char* >(address);
+	for (size_type offset = 0; offset < bytes; offset += page_size)
+	{
+		page[offset] = 0;
+	}
+}
+
+inline detail::size_type detail::next_mark_id() noexcept
+{
+	static std::atomic< size_type > counter{ 1 };
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline detail::size_type detail::worker_count(const size_type requested, const size_type tasks) noexcept
+{
+	size_type workers = requested ? requested : std::thread::hardware_concurrency();
+	if (workers > tasks)
+	{
+		workers = tasks;
+	}
+	return workers ? workers : 1;
+}
+
+template< typename F >
+void detail::run_parallel(const size_type workers, F task)
+{
+	std::exception_ptr error;
+	std::mutex mutex;
+	auto guarded = [&](const size_type worker)
+	{
+		try
+		{
+			task(worker);
+		} catch (...)
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector< std::thread > pool;
+	pool.reserve(workers - 1);
+	try
+	{
+		for (size_type worker = 1; worker < workers; ++worker)
+		{
+			pool.emplace_back(guarded, worker);
+		}
+	} catch (...)
+	{
+		for (auto& thread : pool)
+		{
+			thread.join();
+		}
+		throw;
+	}
+
+	guarded(0);
+	for (auto& thread : pool)
+	{
+		thread.join();
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+inline double detail::ParallelStats::imbalance() const noexcept
+{
+	size_type total = 0;
+	size_type busiest = 0;
+	for (size_type elements : m_elements)
+	{
+		total += elements;
+		busiest = elements > busiest ? elements : busiest;
+	}
+	return total ? static_cast< double >(busiest) * m_elements.size() / total : 1.0;
+}
+
+template< typename F >
+void detail::run_stealing(const std::vector< size_type >& weights, const size_type workers, F task, ParallelStats* stats)
+{
+	std::vector< WorkRange > ranges(workers);
+	std::vector< size_type > elements(workers);
+	std::vector< size_type > blocks(workers);
+	std::vector< size_type > steals(workers);
+
+	// prefix[i] is the weight of tasks [0, i), so any range's remaining weight and its midpoint come from two lookups.
+	std::vector< size_type > prefix(weights.size() + 1);
+	for (size_type i = 0; i < weights.size(); ++i)
+	{
+		prefix[i + 1] = prefix[i] + weights[i];
+	}
+	const size_type total = prefix.back();
+
+	size_type index = 0;
+	size_type accumulated = 0;
+	for (size_type worker = 0; worker < workers; ++worker)
+	{
+		ranges[worker].m_begin = index;
+		const size_type target = total / workers * (worker + 1) + total % workers * (worker + 1) / workers;
+		while (index < weights.size() && (worker + 1 == workers || accumulated < target))
+		{
+			accumulated += weights[index++];
+		}
+		ranges[worker].m_end = index;
+	}
+
+	run_parallel(
+		workers,
+		[&](const size_type worker)
+		{
+			WorkRange& own = ranges[worker];
+			while (true)
+			{
+				size_type next;
+				{
+					std::lock_guard< std::mutex > lock(own.m_mutex);
+					next = own.m_begin < own.m_end ? own.m_begin++ : weights.size();
+				}
+
+				if (next == weights.size())
+				{
+					size_type victim = worker;
+					size_type largest = 0;
+					for (size_type other = 0; other < workers; ++other)
+					{
+						std::lock_guard< std::mutex > lock(ranges[other].m_mutex);
+						const size_type remaining = prefix[ranges[other].m_end] - prefix[ranges[other].m_begin];
+						if (remaining > largest)
+						{
+							largest = remaining;
+							victim = other;
+						}
+					}
+					if (largest == 0)
+					{
+						break;
+					}
+
+					size_type begin;
+					size_type end;
+					{
+						// The victim keeps the first task reaching half its remaining weight; the thief takes at least one task.
+						std::lock_guard< std::mutex > lock(ranges[victim].m_mutex);
+						const size_type first = ranges[victim].m_begin;
+						end = ranges[victim].m_end;
+						if (first == end)
+						{
+							continue;
+						}
+						const size_type half = prefix[first] + (prefix[end] - prefix[first]) / 2;
+						begin = static_cast< size_type >(std::lower_bound(prefix.begin() + first + 1, prefix.begin() + end, half) - prefix.begin());
+						begin = begin < end ? begin : end - 1;
+						ranges[victim].m_end = begin;
+					}
+					{
+						std::lock_guard< std::mutex > lock(own.m_mutex);
+						own.m_begin = begin;
+						own.m_end = end;
+					}
+					++steals[worker];
+					continue;
+				}
+
+				task(worker, next);
+				elements[worker] += weights[next];
+				++blocks[worker];
+			}
+		});
+
+	if (stats)
+	{
+		stats->m_elements = std::move(elements);
+		stats->m_blocks = std::move(blocks);
+		stats->m_steals = std::move(steals);
+	}
+}
+
+// FENWICK IMPLEMENTATION
+
+inline void detail::Fenwick::push_back(const size_type value)
+{
+	const size_type index = m_tree.size();
+	m_tree.push_back(value + prefix(index - 1) - prefix(index - (index & (~index + 1))));
+}
+
+inline void detail::Fenwick::reserve(const size_type count)
+{
+	m_tree.reserve(count + 1);
+}
+
+inline void detail::Fenwick::add(const size_type index, const std::ptrdiff_t delta) noexcept
+{
+	for (size_type i = index + 1; i < m_tree.size(); i += i & (~i + 1))
+	{
+		m_tree[i] += static_cast< size_type >(delta);
+	}
+}
+
+inline void detail::Fenwick::assign(const std::vector< size_type >& values)
+{
+	m_tree.assign(values.size() + 1, 0);
+	for (size_type i = 1; i < m_tree.size(); ++i)
+	{
+		m_tree[i] += values[i - 1];
+		const size_type parent = i + (i & (~i + 1));
+		if (parent < m_tree.size())
+		{
+			m_tree[parent] += m_tree[i];
+		}
+	}
+}
+
+inline detail::size_type detail::Fenwick::prefix(size_type count) const noexcept
+{
+	size_type result = 0;
+	for (; count > 0; count -= count & (~count + 1))
+	{
+		result += m_tree[count];
+	}
+	return result;
+}
+
+inline detail::size_type detail::Fenwick::lower_bound(size_type& rank) const noexcept
+{
+	size_type position = 0;
+	for (size_type step = std::bit_floor(size()); step > 0; step >>= 1)
+	{
+		if (position + step < m_tree.size() && m_tree[position + step] <= rank)
+		{
+			position += step;
+			rank -= m_tree[position];
+		}
+	}
+	return position;
+}
+
+inline detail::size_type detail::Fenwick::size() const noexcept
+{
+	return m_tree.size() - 1;
+}
+
+inline void detail::Fenwick::clear() noexcept
+{
+	m_tree.resize(1);
+}
+
+inline void detail::Fenwick::swap(Fenwick& other) noexcept
+{
+	m_tree.swap(other.m_tree);
+}
+
+// BITTREE IMPLEMENTATION
+
+inline void detail::BitTree::resize(const size_type count)
+{
+	const size_type words = (count + 63) / 64;
+	if (!m_levels.empty() && words <= m_levels.front().size())
+	{
+		return;
+	}
+
+	// Grows geometrically and rebuilds the summaries, so repeated one-block growth stays amortised O(1).
+	std::vector< std::uint64_t > leaves;
+	if (!m_levels.empty())
+	{
+		leaves.swap(m_levels.front());
+	}
+	leaves.resize(words > 2 * leaves.size() ? words : 2 * leaves.size());
+	m_levels.clear();
+	m_levels.push_back(std::move(leaves));
+	while (m_levels.back().size() > 1)
+	{
+		const std::vector< std::uint64_t >& below = m_levels.back();
+		std::vector< std::uint64_t > level((below.size() + 63) / 64);
+		for (size_type i = 0; i < below.size(); ++i)
+		{
+			if (below[i])
+			{
+				level[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+			}
+		}
+		m_levels.push_back(std::move(level));
+	}
+}
+
+inline void detail::BitTree::set(size_type index) noexcept
+{
+	for (auto& level : m_levels)
+	{
+		const bool was_empty = level[index / 64] == 0;
+		level[index / 64] |= std::uint64_t{ 1 } << (index % 64);
+		if (!was_empty)
+		{
+			break;
+		}
+		index /= 64;
+	}
+}
+
+inline void detail::BitTree::reset(size_type index) noexcept
+{
+	for (auto& level : m_levels)
+	{
+		level[index / 64] &= ~(std::uint64_t{ 1 } << (index % 64));
+		if (level[index / 64] != 0)
+		{
+			break;
+		}
+		index /= 64;
+	}
+}
+
+inline detail::size_type detail::BitTree::first() const noexcept
+{
+	if (m_levels.empty() || m_levels.back().front() == 0)
+	{
+		return npos;
+	}
+
+	size_type index = 0;
+	for (auto level = m_levels.rbegin(); level != m_levels.rend(); ++level)
+	{
+		index = index * 64 + std::countr_zero((*level)[index]);
+	}
+	return index;
+}
+
+inline detail::size_type detail::BitTree::last() const noexcept
+{
+	if (m_levels.empty() || m_levels.back().front() == 0)
+	{
+		return npos;
+	}
+
+	size_type index = 0;
+	for (auto level = m_levels.rbegin(); level != m_levels.rend(); ++level)
+	{
+		index = index * 64 + 63 - std::countl_zero((*level)[index]);
+	}
+	return index;
+}
+
+inline void detail::BitTree::clear() noexcept
+{
+	for (auto& level : m_levels)
+	{
+		std::fill(level.begin(), level.end(), 0);
+	}
+}
+
+inline void detail::BitTree::swap(BitTree& other) noexcept
+{
+	m_levels.swap(other.m_levels);
+}
@@ -0,0 +1,732 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// INTERFACE
+
+namespace detail
+{
+	inline std::atomic< std::uint64_t > next_storage_id{ 1 };
+	inline constexpr std::size_t local_cache_entries = 8;
+	inline constexpr std::size_t retire_threshold = 64;
+
+	std::shared_ptr< std::atomic< bool > > thread_alive();
+
+	// Sequence lock: writers serialize on an odd version, readers copy without writing shared state and retry when
+	// the version moved underneath them.
+	struct SeqLock
+	{
+		std::atomic< std::uint64_t > m_version{};
+
+		void lock() noexcept;
+		void unlock() noexcept;
+		std::uint64_t read_begin() const noexcept;
+		bool read_retry(std::uint64_t version) const noexcept;
+	};
+}	 // namespace detail
+
+// Each thread inserts into blocks it owns, reusing slots from its own free cache, so inserts take no shared lock.
+// Blocks are published to the shared registry once, when created; element addresses stay stable until erased.
+// Any thread may erase: slots freed by other threads go to a lock-free per-block stack the owner drains in bulk.
+// When a thread exits, the next thread to collect takes over its blocks, so their emptied slots are still released.
+// Readers never lock: erased elements are destroyed, and their slots and emptied blocks reused or freed, only once
+// every reader that was traversing at erase time has finished (epoch-based reclamation).
+// update() bumps the block's sequence lock, so snapshot_each can copy a consistent view of each block optimistically
+// and retry just that block when an update interfered. Insert and erase only flip a slot's live flag and stay
+// lock-free: a slot is published fully constructed, and an erased element stays intact until the grace period ends.
+template< typename T >
+class ConcurrentBucketStorage
+{
+	struct Slot;
+	struct Block;
+	struct Local;
+	struct PinGuard;
+
+  public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+
+  private:
+	struct Slot
+	{
+		Block* m_block{};
+		Slot* m_next_free{};
+		alignas(value_type) unsigned char m_storage[sizeof(value_type)];
+	};
+
+	struct Block
+	{
+		Slot* m_slots;
+		std::atomic< bool >* m_live;
+		size_type m_capacity;
+		size_type m_used{};
+		std::atomic< Local* > m_owner;
+		std::atomic< size_type > m_size{};
+		std::atomic< size_type > m_occupied{};
+		std::atomic< Slot* > m_remote{};
+		std::atomic< Block* > m_next{};
+		detail::SeqLock m_seqlock;
+
+		Block(const size_type capacity, Local* owner) :
+			m_slots(static_cast< Slot* >(operator new(capacity * sizeof(Slot), std::align_val_t(alignof(Slot))))),
+			m_live(new std::atomic< bool >[capacity]), m_capacity(capacity), m_owner(owner)
+		{
+			for (size_type i = 0; i < capacity; ++i)
+			{
+				new (m_slots + i) Slot();
+				m_slots[i].m_block = this;
+				m_live[i].store(false, std::memory_order_relaxed);
+			}
+		}
+
+		~Block()
+		{
+			delete[] m_live;
+			operator delete(m_slots, std::align_val_t(alignof(Slot)));
+		}
+	};
+
+	struct Retired
+	{
+		Slot* m_slot;
+		Block* m_block;
+		std::uint64_t m_epoch;
+	};
+
+	struct Local
+	{
+		std::thread::id m_thread;
+		std::shared_ptr< std::atomic< bool > > m_alive;
+		bool m_adopted{};
+		Block* m_current{};
+		std::vector< Slot* > m_free;
+		std::vector< Block* > m_blocks;
+		std::vector< Retired > m_retired;
+		std::atomic< bool > m_remote_pending{};
+		std::atomic< std::uint64_t > m_reader_epoch{};
+		size_type m_pin_depth{};
+		size_type m_collect_size{};
+		std::uint64_t m_collect_epoch{};
+		Local* m_next{};
+	};
+
+	struct PinGuard
+	{
+		ConcurrentBucketStorage& m_storage;
+		Local& m_local;
+
+		explicit PinGuard(ConcurrentBucketStorage& storage) : m_storage(storage), m_local(storage.local())
+		{
+			if (m_local.m_pin_depth++ == 0)
+			{
+				m_local.m_reader_epoch.store(m_storage.m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+			}
+		}
+
+		~PinGuard()
+		{
+			if (--m_local.m_pin_depth == 0)
+			{
+				m_local.m_reader_epoch.store(0, std::memory_order_release);
+			}
+		}
+	};
+
+	size_type m_block_capacity;
+	std::uint64_t m_id;
+	std::atomic< Block* > m_blocks{};
+	std::atomic< std::uint64_t > m_epoch{ 1 };
+	std::mutex m_mutex;
+	std::atomic< Local* > m_locals{};
+
+	Local& local();
+	Block* publish_block(Local& owner);
+	void unlink_block(Block* block);
+	void reclaim_remote(Local& owner);
+	void release_empty_blocks(Local& owner);
+	void return_slot(Slot* slot, Local& own);
+	void adopt_orphans(Local& own);
+	void collect(Local& own);
+	static void reserve_retired(Local& own);
+	template< typename U >
+	value_type* insert_impl(U&& value);
+	static Slot* slot_of(const value_type* value) noexcept;
+	static value_type* element(Slot* slot) noexcept;
+
+  public:
+	ConcurrentBucketStorage();
+	explicit ConcurrentBucketStorage(size_type block_capacity);
+	ConcurrentBucketStorage(const ConcurrentBucketStorage& other) = delete;
+	~ConcurrentBucketStorage();
+	ConcurrentBucketStorage& operator=(const ConcurrentBucketStorage& other) = delete;
+	value_type* insert(const value_type& value);
+	value_type* insert(value_type&& value);
+	void erase(value_type* value);
+	template< typename F >
+	void update(value_type* value, F f);
+	void collect();
+	[[nodiscard]] bool empty() const;
+	[[nodiscard]] size_type size() const;
+	[[nodiscard]] size_type capacity() const;
+	template< typename F >
+	void for_each(F f);
+	template< typename F >
+	void for_each(F f) const;
+	template< typename F >
+	void snapshot_each(F f) const;
+};
+
+// CONCURRENTBUCKETSTORAGE IMPLEMENTATION
+
+template< typename T >
+ConcurrentBucketStorage< T >::ConcurrentBucketStorage() : ConcurrentBucketStorage(64)
+{
+}
+
+template< typename T >
+ConcurrentBucketStorage< T >::ConcurrentBucketStorage(const size_type block_capacity) :
+	m_block_capacity(block_capacity), m_id(detail::next_storage_id.fetch_add(1, std::memory_order_relaxed))
+{
+	if (block_capacity == 0)
+	{
+		throw std::invalid_argument("Block capacity must be positive.");
+	}
+}
+
+template< typename T >
+ConcurrentBucketStorage< T >::~ConcurrentBucketStorage()
+{
+	for (Local* curr = m_locals.load(std::memory_order_acquire); curr; curr = curr->m_next)
+	{
+		for (const Retired& retired : curr->m_retired)
+		{
+			if (retired.m_slot)
+			{
+				element(retired.m_slot)->~value_type();
+			}
+			else
+			{
+				delete retired.m_block;
+			}
+		}
+	}
+
+	Block* block = m_blocks.load(std::memory_order_acquire);
+	while (block)
+	{
+		for (size_type i = 0; i < block->m_capacity; ++i)
+		{
+			if (block->m_live[i].load(std::memory_order_relaxed))
+			{
+				element(block->m_slots + i)->~value_type();
+			}
+		}
+		Block* next = block->m_next.load(std::memory_order_relaxed);
+		delete block;
+		block = next;
+	}
+
+	Local* curr = m_locals.load(std::memory_order_acquire);
+	while (curr)
+	{
+		Local* next = curr->m_next;
+		delete curr;
+		curr = next;
+	}
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::value_type* ConcurrentBucketStorage< T >::insert(const value_type& value)
+{
+	return insert_impl(value);
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::value_type* ConcurrentBucketStorage< T >::insert(value_type&& value)
+{
+	return insert_impl(std::move(value));
+}
+
+template< typename T >
+template< typename U >
+typename ConcurrentBucketStorage< T >::value_type* ConcurrentBucketStorage< T >::insert_impl(U&& value)
+{
+	Local& own = local();
+	if (own.m_free.empty() && own.m_remote_pending.load(std::memory_order_relaxed))
+	{
+		reclaim_remote(own);
+	}
+
+	const bool reused = !own.m_free.empty();
+	if (!reused && (!own.m_current || own.m_current->m_used == own.m_current->m_capacity))
+	{
+		publish_block(own);
+	}
+
+	Slot* slot = reused ? own.m_free.back() : own.m_current->m_slots + own.m_current->m_used;
+	Block* block = slot->m_block;
+	value_type* result = new (slot->m_storage) value_type(std::forward< U >(value));
+
+	if (reused)
+	{
+		own.m_free.pop_back();
+	}
+	else
+	{
+		++block->m_used;
+	}
+
+	block->m_size.fetch_add(1, std::memory_order_relaxed);
+	block->m_occupied.fetch_add(1, std::memory_order_relaxed);
+	block->m_live[slot - block->m_slots].store(true, std::memory_order_release);
+	return result;
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::erase(value_type* value)
+{
+	Slot* slot = slot_of(value);
+	Block* block = slot->m_block;
+	Local& own = local();
+	reserve_retired(own);
+
+	block->m_live[slot - block->m_slots].store(false, std::memory_order_seq_cst);
+	block->m_size.fetch_sub(1, std::memory_order_relaxed);
+	own.m_retired.push_back({ slot, nullptr, m_epoch.load(std::memory_order_seq_cst) });
+
+	// While a reader holds the epoch back, collecting again finds nothing new; wait for progress or twice the backlog.
+	const size_type retired = own.m_retired.size();
+	if (retired >= detail::retire_threshold &&
+		(retired >= 2 * own.m_collect_size || m_epoch.load(std::memory_order_relaxed) != own.m_collect_epoch))
+	{
+		collect(own);
+	}
+}
+
+template< typename T >
+template< typename F >
+void ConcurrentBucketStorage< T >::update(value_type* value, F f)
+{
+	Block* block = slot_of(value)->m_block;
+	block->m_seqlock.lock();
+	try
+	{
+		f(*value);
+	} catch (...)
+	{
+		block->m_seqlock.unlock();
+		throw;
+	}
+	block->m_seqlock.unlock();
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::collect()
+{
+	collect(local());
+}
+
+template< typename T >
+bool ConcurrentBucketStorage< T >::empty() const
+{
+	return size() == 0;
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::size_type ConcurrentBucketStorage< T >::size() const
+{
+	PinGuard guard(const_cast< ConcurrentBucketStorage& >(*this));
+	size_type result = 0;
+	for (Block* block = m_blocks.load(std::memory_order_acquire); block; block = block->m_next.load(std::memory_order_acquire))
+	{
+		result += block->m_size.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::size_type ConcurrentBucketStorage< T >::capacity() const
+{
+	PinGuard guard(const_cast< ConcurrentBucketStorage& >(*this));
+	size_type result = 0;
+	for (Block* block = m_blocks.load(std::memory_order_acquire); block; block = block->m_next.load(std::memory_order_acquire))
+	{
+		result += block->m_capacity;
+	}
+	return result;
+}
+
+template< typename T >
+template< typename F >
+void ConcurrentBucketStorage< T >::for_each(F f)
+{
+	PinGuard guard(*this);
+	for (Block* block = m_blocks.load(std::memory_order_acquire); block; block = block->m_next.load(std::memory_order_acquire))
+	{
+		for (size_type i = 0; i < block->m_capacity; ++i)
+		{
+			if (block->m_live[i].load(std::memory_order_seq_cst))
+			{
+				f(*element(block->m_slots + i));
+			}
+		}
+	}
+}
+
+template< typename T >
+template< typename F >
+void ConcurrentBucketStorage< T >::for_each(F f) const
+{
+	const_cast< ConcurrentBucketStorage* >(this)->for_each([&f](reference value) { f(static_cast< const_reference >(value)); });
+}
+
+template< typename T >
+template< typename F >
+void ConcurrentBucketStorage< T >::snapshot_each(F f) const
+{
+	static_assert(std::is_trivially_copyable_v< value_type >, "snapshot_each copies elements bytewise while writers may be active.");
+
+	struct alignas(value_type) Copy
+	{
+		unsigned char m_bytes[sizeof(value_type)];
+	};
+
+	PinGuard guard(const_cast< ConcurrentBucketStorage& >(*this));
+	std::vector< Copy > copies(m_block_capacity);
+	for (Block* block = m_blocks.load(std::memory_order_acquire); block; block = block->m_next.load(std::memory_order_acquire))
+	{
+		size_type count;
+		std::uint64_t version;
+		do
+		{
+			version = block->m_seqlock.read_begin();
+			count = 0;
+			for (size_type i = 0; i < block->m_capacity; ++i)
+			{
+				if (block->m_live[i].load(std::memory_order_acquire))
+				{
+					std::memcpy(copies[count++].m_bytes, block->m_slots[i].m_storage, sizeof(value_type));
+				}
+			}
+		} while (block->m_seqlock.read_retry(version));
+
+		for (size_type i = 0; i < count; ++i)
+		{
+			f(static_cast< const_reference >(*std::launder(reinterpret_cast< const value_type* >(copies[i].m_bytes))));
+		}
+	}
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::Local& ConcurrentBucketStorage< T >::local()
+{
+	thread_local std::vector< std::pair< std::uint64_t, Local* > > cache;
+	for (const auto& entry : cache)
+	{
+		if (entry.first == m_id)
+		{
+			return *entry.second;
+		}
+	}
+
+	Local* result = nullptr;
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		for (Local* curr = m_locals.load(std::memory_order_relaxed); curr; curr = curr->m_next)
+		{
+			if (curr->m_thread == std::this_thread::get_id() && curr->m_alive->load(std::memory_order_acquire))
+			{
+				result = curr;
+				break;
+			}
+		}
+		if (!result)
+		{
+			result = new Local();
+			result->m_thread = std::this_thread::get_id();
+			result->m_alive = detail::thread_alive();
+			result->m_next = m_locals.load(std::memory_order_relaxed);
+			m_locals.store(result, std::memory_order_release);
+		}
+	}
+
+	if (cache.size() == detail::local_cache_entries)
+	{
+		cache.erase(cache.begin());
+	}
+	cache.emplace_back(m_id, result);
+	return *result;
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::Block* ConcurrentBucketStorage< T >::publish_block(Local& owner)
+{
+	auto block = new Block(m_block_capacity, &owner);
+	try
+	{
+		owner.m_blocks.push_back(block);
+	} catch (...)
+	{
+		delete block;
+		throw;
+	}
+
+	Block* head = m_blocks.load(std::memory_order_relaxed);
+	do
+	{
+		block->m_next.store(head, std::memory_order_relaxed);
+	} while (!m_blocks.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+	owner.m_current = block;
+	return block;
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::unlink_block(Block* block)
+{
+	std::lock_guard< std::mutex > lock(m_mutex);
+	Block* next = block->m_next.load(std::memory_order_relaxed);
+	Block* head = block;
+	// On failure head may be a block another thread just published; acquire makes its links visible before the walk.
+	if (!m_blocks.compare_exchange_strong(head, next, std::memory_order_release, std::memory_order_acquire))
+	{
+		Block* prev = head;
+		while (prev->m_next.load(std::memory_order_relaxed) != block)
+		{
+			prev = prev->m_next.load(std::memory_order_relaxed);
+		}
+		prev->m_next.store(next, std::memory_order_release);
+	}
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::reclaim_remote(Local& owner)
+{
+	if (!owner.m_remote_pending.exchange(false, std::memory_order_acquire))
+	{
+		return;
+	}
+
+	for (Block* block : owner.m_blocks)
+	{
+		for (Slot* slot = block->m_remote.exchange(nullptr, std::memory_order_acquire); slot; slot = slot->m_next_free)
+		{
+			owner.m_free.push_back(slot);
+		}
+	}
+	release_empty_blocks(owner);
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::release_empty_blocks(Local& owner)
+{
+	for (size_type i = 0; i < owner.m_blocks.size();)
+	{
+		Block* block = owner.m_blocks[i];
+		if (block == owner.m_current || block->m_occupied.load(std::memory_order_acquire) != 0)
+		{
+			++i;
+			continue;
+		}
+
+		reserve_retired(owner);
+		block->m_remote.exchange(nullptr, std::memory_order_acquire);
+		std::erase_if(owner.m_free, [block](Slot* slot) { return slot->m_block == block; });
+		owner.m_blocks[i] = owner.m_blocks.back();
+		owner.m_blocks.pop_back();
+
+		unlink_block(block);
+		owner.m_retired.push_back({ nullptr, block, m_epoch.load(std::memory_order_seq_cst) });
+	}
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::return_slot(Slot* slot, Local& own)
+{
+	Block* block = slot->m_block;
+	Local* owner = block->m_owner.load(std::memory_order_acquire);
+
+	if (owner == &own)
+	{
+		owner->m_free.push_back(slot);
+		block->m_occupied.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	Slot* head = block->m_remote.load(std::memory_order_relaxed);
+	do
+	{
+		slot->m_next_free = head;
+	} while (!block->m_remote.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+	block->m_occupied.fetch_sub(1, std::memory_order_release);
+	owner->m_remote_pending.store(true, std::memory_order_release);
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::collect(Local& own)
+{
+	adopt_orphans(own);
+	std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+	bool quiescent = true;
+	for (Local* other = m_locals.load(std::memory_order_acquire); other && quiescent; other = other->m_next)
+	{
+		const std::uint64_t observed = other->m_reader_epoch.load(std::memory_order_seq_cst);
+		quiescent = observed == 0 || observed == epoch;
+	}
+	if (quiescent)
+	{
+		m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+	}
+
+	// Own slots go back to m_free; reserving first keeps the compaction below from throwing halfway.
+	const std::uint64_t safe = m_epoch.load(std::memory_order_seq_cst);
+	const size_type needed = own.m_free.size() + own.m_retired.size();
+	if (own.m_free.capacity() < needed)
+	{
+		own.m_free.reserve(needed > 2 * own.m_free.capacity() ? needed : 2 * own.m_free.capacity());
+	}
+
+	size_type kept = 0;
+	for (const Retired& retired : own.m_retired)
+	{
+		if (retired.m_epoch + 2 > safe)
+		{
+			own.m_retired[kept++] = retired;
+		}
+		else if (retired.m_slot)
+		{
+			element(retired.m_slot)->~value_type();
+			return_slot(retired.m_slot, own);
+		}
+		else
+		{
+			delete retired.m_block;
+		}
+	}
+	own.m_retired.resize(kept);
+
+	release_empty_blocks(own);
+	own.m_collect_size = own.m_retired.size();
+	own.m_collect_epoch = safe;
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::adopt_orphans(Local& own)
+{
+	std::lock_guard< std::mutex > lock(m_mutex);
+	for (Local* other = m_locals.load(std::memory_order_relaxed); other; other = other->m_next)
+	{
+		if (other == &own || other->m_adopted || other->m_alive->load(std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		// The exited owner no longer touches its state; remote erasers that still see it push to the block's stack.
+		own.m_blocks.reserve(own.m_blocks.size() + other->m_blocks.size());
+		own.m_free.reserve(own.m_free.size() + other->m_free.size());
+		own.m_retired.reserve(own.m_retired.size() + other->m_retired.size());
+		for (Block* block : other->m_blocks)
+		{
+			block->m_owner.store(&own, std::memory_order_release);
+		}
+		own.m_blocks.insert(own.m_blocks.end(), other->m_blocks.begin(), other->m_blocks.end());
+		own.m_free.insert(own.m_free.end(), other->m_free.begin(), other->m_free.end());
+		own.m_retired.insert(own.m_retired.end(), other->m_retired.begin(), other->m_retired.end());
+		other->m_blocks.clear();
+		other->m_free.clear();
+		other->m_retired.clear();
+		other->m_current = nullptr;
+		other->m_adopted = true;
+		own.m_remote_pending.store(true, std::memory_order_release);
+	}
+}
+
+template< typename T >
+void ConcurrentBucketStorage< T >::reserve_retired(Local& own)
+{
+	// Makes room for one more entry before an element is unlinked, growing geometrically.
+	if (own.m_retired.size() == own.m_retired.capacity())
+	{
+		const size_type grown = 2 * own.m_retired.capacity();
+		own.m_retired.reserve(grown > detail::retire_threshold ? grown : detail::retire_threshold);
+	}
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::Slot* ConcurrentBucketStorage< T >::slot_of(const value_type* value) noexcept
+{
+	auto bytes = reinterpret_cast< unsigned char* >(const_cast< value_type* >(value));
+	return reinterpret_cast< Slot* >(bytes - offsetof(Slot, m_storage));
+}
+
+template< typename T >
+typename ConcurrentBucketStorage< T >::value_type* ConcurrentBucketStorage< T >::element(Slot* slot) noexcept
+{
+	return std::launder(reinterpret_cast< value_type* >(slot->m_storage));
+}
+
+// DETAIL IMPLEMENTATION
+
+inline std::shared_ptr< std::atomic< bool > > detail::thread_alive()
+{
+	// Cleared by the thread's exit; storages hold their own reference, so the flag outlives the thread.
+	struct Token
+	{
+		std::shared_ptr< std::atomic< bool > > m_alive = std::make_shared< std::atomic< bool > >(true);
+
+		~Token()
+		{
+			m_alive->store(false, std::memory_order_release);
+		}
+	};
+
+	thread_local Token token;
+	return token.m_alive;
+}
+
+// SEQLOCK IMPLEMENTATION
+
+inline void detail::SeqLock::lock() noexcept
+{
+	std::uint64_t version = m_version.load(std::memory_order_relaxed);
+	while ((version & 1) || !m_version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed))
+	{
+		std::this_thread::yield();
+		version = m_version.load(std::memory_order_relaxed);
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void detail::SeqLock::unlock() noexcept
+{
+	m_version.fetch_add(1, std::memory_order_release);
+}
+
+inline std::uint64_t detail::SeqLock::read_begin() const noexcept
+{
+	std::uint64_t version = m_version.load(std::memory_order_acquire);
+	while (version & 1)
+	{
+		std::this_thread::yield();
+		version = m_version.load(std::memory_order_acquire);
+	}
+	return version;
+}
+
+inline bool detail::SeqLock::read_retry(const std::uint64_t version) const noexcept
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return m_version.load(std::memory_order_relaxed) != version;
+}
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "bucket_storage.hpp"
+
+#include <array>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// INTERFACE
+
+// Shards independent BucketStorage instances, each behind its own mutex. insert and erase are thread-safe and
+// lock only the shards they touch, in ascending order; iteration visits the shards in order and must not overlap
+// with writers (for_each locks each shard while visiting it).
+template< typename T, std::size_t Shards = 16 >
+class ShardedBucketStorage
+{
+	static_assert(Shards > 0, "ShardedBucketStorage needs at least one shard.");
+
+	template< typename U >
+	struct ShardedIterator;
+
+	struct alignas(detail::cache_line_size) Shard
+	{
+		mutable std::mutex m_mutex;
+		BucketStorage< T > m_storage;
+	};
+
+  public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using difference_type = std::ptrdiff_t;
+	using size_type = std::size_t;
+	using iterator = ShardedIterator< T >;
+	using const_iterator = ShardedIterator< const T >;
+
+	static constexpr size_type shard_count = Shards;
+
+  private:
+	template< typename U >
+	struct ShardedIterator
+	{
+		using inner_iterator = std::conditional_t< std::is_const_v< U >, typename BucketStorage< T >::const_iterator, typename BucketStorage< T >::iterator >;
+		using shards_pointer = std::conditional_t< std::is_const_v< U >, const std::array< Shard, Shards >*, std::array< Shard, Shards >* >;
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using iterator_concept = std::bidirectional_iterator_tag;
+		using value_type = std::remove_cv_t< U >;
+		using difference_type = std::ptrdiff_t;
+		using pointer = U*;
+		using reference = U&;
+
+	  private:
+		shards_pointer m_shards{};
+		size_type m_shard{};
+		inner_iterator m_inner{};
+
+		void skip_empty();
+
+	  public:
+		ShardedIterator() = default;
+		ShardedIterator(const iterator& other);
+		ShardedIterator(shards_pointer shards, size_type shard, inner_iterator inner);
+		ShardedIterator& operator=(const ShardedIterator& other) = default;
+		ShardedIterator& operator++();
+		ShardedIterator operator++(int);
+		ShardedIterator& operator--();
+		ShardedIterator operator--(int);
+		bool operator==(const ShardedIterator& other) const noexcept;
+		pointer operator->() const;
+		reference operator*() const;
+		shards_pointer shards() const noexcept;
+		size_type shard() const noexcept;
+		inner_iterator inner() const noexcept;
+	};
+
+	std::array< Shard, Shards > m_shards;
+
+	static size_type thread_shard() noexcept;
+
+  public:
+	ShardedBucketStorage() = default;
+	explicit ShardedBucketStorage(size_type block_capacity);
+	ShardedBucketStorage(const ShardedBucketStorage& other) = delete;
+	ShardedBucketStorage& operator=(const ShardedBucketStorage& other) = delete;
+	iterator insert(const value_type& value);
+	iterator insert(value_type&& value);
+	iterator insert_with_key(size_type key, const value_type& value);
+	iterator insert_with_key(size_type key, value_type&& value);
+	iterator erase(const_iterator it);
+	[[nodiscard]] bool empty() const;
+	[[nodiscard]] size_type size() const;
+	[[nodiscard]] BucketStorage< T >& shard(size_type index) noexcept;
+	[[nodiscard]] std::mutex& shard_mutex(size_type index) noexcept;
+	template< typename F >
+	void for_each(F f);
+	[[nodiscard]] iterator begin() noexcept;
+	[[nodiscard]] const_iterator begin() const noexcept;
+	[[nodiscard]] iterator end() noexcept;
+	[[nodiscard]] const_iterator end() const noexcept;
+};
+
+// SHARDEDBUCKETSTORAGE IMPLEMENTATION
+
+template< typename T, std::size_t Shards >
+ShardedBucketStorage< T, Shards >::ShardedBucketStorage(const size_type block_capacity)
+{
+	for (Shard& shard : m_shards)
+	{
+		shard.m_storage = BucketStorage< T >(block_capacity);
+	}
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::insert(const value_type& value)
+{
+	return insert_with_key(thread_shard(), value);
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::insert(value_type&& value)
+{
+	return insert_with_key(thread_shard(), std::move(value));
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::insert_with_key(const size_type key, const value_type& value)
+{
+	const size_type index = key % Shards;
+	std::lock_guard< std::mutex > lock(m_shards[index].m_mutex);
+	return iterator(&m_shards, index, m_shards[index].m_storage.insert(value));
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::insert_with_key(const size_type key, value_type&& value)
+{
+	const size_type index = key % Shards;
+	std::lock_guard< std::mutex > lock(m_shards[index].m_mutex);
+	return iterator(&m_shards, index, m_shards[index].m_storage.insert(std::move(value)));
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::erase(const_iterator it)
+{
+	size_type index = it.shard();
+	std::unique_lock< std::mutex > lock(m_shards[index].m_mutex);
+	auto next = m_shards[index].m_storage.erase(it.inner());
+
+	while (index + 1 < Shards && next == m_shards[index].m_storage.end())
+	{
+		std::unique_lock< std::mutex > next_lock(m_shards[index + 1].m_mutex);
+		lock.swap(next_lock);
+		next_lock.unlock();
+		next = m_shards[++index].m_storage.begin();
+	}
+	return iterator(&m_shards, index, next);
+}
+
+template< typename T, std::size_t Shards >
+bool ShardedBucketStorage< T, Shards >::empty() const
+{
+	return size() == 0;
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::size_type ShardedBucketStorage< T, Shards >::size() const
+{
+	size_type result = 0;
+	for (const Shard& shard : m_shards)
+	{
+		std::lock_guard< std::mutex > lock(shard.m_mutex);
+		result += shard.m_storage.size();
+	}
+	return result;
+}
+
+template< typename T, std::size_t Shards >
+BucketStorage< T >& ShardedBucketStorage< T, Shards >::shard(const size_type index) noexcept
+{
+	return m_shards[index].m_storage;
+}
+
+template< typename T, std::size_t Shards >
+std::mutex& ShardedBucketStorage< T, Shards >::shard_mutex(const size_type index) noexcept
+{
+	return m_shards[index].m_mutex;
+}
+
+template< typename T, std::size_t Shards >
+template< typename F >
+void ShardedBucketStorage< T, Shards >::for_each(F f)
+{
+	for (Shard& shard : m_shards)
+	{
+		std::lock_guard< std::mutex > lock(shard.m_mutex);
+		shard.m_storage.for_each(std::ref(f));
+	}
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::begin() noexcept
+{
+	return iterator(&m_shards, 0, m_shards[0].m_storage.begin());
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::const_iterator ShardedBucketStorage< T, Shards >::begin() const noexcept
+{
+	return const_iterator(&m_shards, 0, m_shards[0].m_storage.begin());
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::iterator ShardedBucketStorage< T, Shards >::end() noexcept
+{
+	return iterator(&m_shards, Shards - 1, m_shards[Shards - 1].m_storage.end());
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::const_iterator ShardedBucketStorage< T, Shards >::end() const noexcept
+{
+	return const_iterator(&m_shards, Shards - 1, m_shards[Shards - 1].m_storage.end());
+}
+
+template< typename T, std::size_t Shards >
+typename ShardedBucketStorage< T, Shards >::size_type ShardedBucketStorage< T, Shards >::thread_shard() noexcept
+{
+	return std::hash< std::thread::id >{}(std::this_thread::get_id());
+}
+
+// SHARDEDITERATOR IMPLEMENTATION
+
+template< typename T, std::size_t Shards >
+template< typename U >
+ShardedBucketStorage< T, Shards >::ShardedIterator< U >::ShardedIterator(const iterator& other) :
+	m_shards(other.shards()), m_shard(other.shard()), m_inner(other.inner())
+{
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+ShardedBucketStorage< T, Shards >::ShardedIterator< U >::ShardedIterator(shards_pointer shards, const size_type shard, inner_iterator inner) :
+	m_shards(shards), m_shard(shard), m_inner(inner)
+{
+	skip_empty();
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+void ShardedBucketStorage< T, Shards >::ShardedIterator< U >::skip_empty()
+{
+	while (m_shard + 1 < Shards && m_inner == (*m_shards)[m_shard].m_storage.end())
+	{
+		++m_shard;
+		m_inner = (*m_shards)[m_shard].m_storage.begin();
+	}
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >& ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator++()
+{
+	++m_inner;
+	skip_empty();
+	return *this;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U > ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator++(int)
+{
+	ShardedIterator temp = *this;
+	++*this;
+	return temp;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >& ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator--()
+{
+	while (m_shard > 0 && m_inner == (*m_shards)[m_shard].m_storage.begin())
+	{
+		--m_shard;
+		m_inner = (*m_shards)[m_shard].m_storage.end();
+	}
+	--m_inner;
+	return *this;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U > ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator--(int)
+{
+	ShardedIterator temp = *this;
+	--*this;
+	return temp;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+bool ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator==(const ShardedIterator& other) const noexcept
+{
+	return m_shard == other.m_shard && m_inner == other.m_inner;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >::pointer ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator->() const
+{
+	return m_inner.operator->();
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >::reference ShardedBucketStorage< T, Shards >::ShardedIterator< U >::operator*() const
+{
+	return *m_inner;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >::shards_pointer ShardedBucketStorage< T, Shards >::ShardedIterator< U >::shards() const noexcept
+{
+	return m_shards;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::size_type ShardedBucketStorage< T, Shards >::ShardedIterator< U >::shard() const noexcept
+{
+	return m_shard;
+}
+
+template< typename T, std::size_t Shards >
+template< typename U >
+typename ShardedBucketStorage< T, Shards >::template ShardedIterator< U >::inner_iterator ShardedBucketStorage< T, Shards >::ShardedIterator< U >::inner() const noexcept
+{
+	return m_inner;
+}